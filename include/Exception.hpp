@@ -36,9 +36,16 @@ class CentroidsException;
 class ConstraintException;
 class CreateLigandException;
 class CreateMultimerException;
+class ExportTransformsException;
+class FCCException;
+class MetricsException;
+class NeighborGraphException;
 class PDBOpenException;
 class PathException;
+class PoseIndexException;
+class PoseRMSDException;
 class PruningException;
+class SelectionException;
 class SplitException;
 class ZDOCKInvalidFormat;
 class ZDOCKUnsupported;
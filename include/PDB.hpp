@@ -26,8 +26,10 @@
 
 #pragma once
 
+#include "Selection.hpp"
 #include "pdb++.h"
 #include <Eigen/Dense>
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -54,12 +56,65 @@ public:
   RecordCoord() : serialNum(0), atomName(""), resName(""), chain('\0'), resNum(0) {}
 };
 
-class Model;
+/**
+ * @brief Residue in the structure hierarchy; a contiguous range of atoms
+ */
+class ResidueRange {
+public:
+  //! first atom (index into PDB::atoms() and PDB::matrix() columns)
+  size_t begin;
+  //! one past the last atom
+  size_t end;
+  //! Chain ID
+  char chain;
+  //! Residue sequence number
+  int seqNum;
+  //! Residue insertion code
+  char insertCode;
+  //! Residue name, packed (see AtomTable::pack)
+  uint32_t name;
+  //! mean coordinate of the residue's atoms
+  Eigen::Vector3d centroid;
+  //! largest distance of any of the residue's atoms to the centroid
+  double radius;
+  /**
+   * @brief Constructor
+   */
+  ResidueRange()
+      : begin(0), end(0), chain('\0'), seqNum(0), insertCode('\0'), name(0),
+        centroid(Eigen::Vector3d::Zero()), radius(0.0) {}
+  //! number of atoms
+  size_t size() const { return end - begin; }
+};
+
+/**
+ * @brief Chain in the structure hierarchy; a contiguous range of residues
+ */
+class ChainRange {
+public:
+  //! first residue (index into PDB::residues())
+  size_t begin;
+  //! one past the last residue
+  size_t end;
+  //! Chain ID
+  char chain;
+  /**
+   * @brief Constructor
+   */
+  ChainRange() : begin(0), end(0), chain('\0') {}
+  //! number of residues
+  size_t size() const { return end - begin; }
+};
+
+template <typename T> class ModelT;
 
 /**
  * @brief Collection of PDB records, representing a PDB file
+ *
+ * Coordinates are exposed as a matrix of scalar type T; see PDB (double
+ * precision) and PDBf (single precision).
  */
-class PDB {
+template <typename T> class PDBT {
 private:
   /**
    * @brief Read from file
@@ -67,18 +122,37 @@ private:
    * @param fn file name
    */
   void read_(const std::string &fn);
+  /**
+   * @brief Restrict atoms (and those of all models) to a selection
+   *
+   * @param selection compiled selection
+   */
+  void select_(const Selection &selection);
+  /**
+   * @brief Write coordinates back into the atom records, if out of date
+   *
+   * setMatrix() only replaces the coordinate matrix; records are updated
+   * lazily, once they are accessed.
+   */
+  void sync_() const;
+  /**
+   * @brief (Re)build chain and residue index, if out of date
+   */
+  void index_() const;
 
 public:
+  //! Coordinate scalar type
+  typedef T Scalar;
   //! PDB coordinate matrix type
-  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Matrix;
   //! Shorthand for eigen Transformation type
-  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+  typedef Eigen::Transform<T, 3, Eigen::Affine> Transform;
   //! Coordinate (x, y, z)
-  typedef Eigen::Vector3d Coord;
+  typedef Eigen::Matrix<T, 3, 1> Coord;
   //! Shared Pointer type for PDB record
   typedef std::shared_ptr<libpdb::PDB> Record;
   //! Shared Pointer type for Model
-  typedef std::shared_ptr<zdock::Model> Model;
+  typedef std::shared_ptr<ModelT<T>> Model;
 
 protected:
   std::vector<Model> models_;   //!< zero or more models
@@ -86,31 +160,47 @@ protected:
   std::vector<Record> atoms_;   //!< just atoms
   Matrix matrix_;               //!< eigen matrix w/ atom coords
   // atomic inserts...
-  std::mutex lock_; //!< lock for atomic updates
+  mutable std::mutex lock_; //!< lock for atomic updates
+  //! records are out of date with respect to matrix_
+  mutable std::atomic<bool> dirty_;
+  //! chain/residue index over atoms_ (see index_())
+  mutable std::vector<ChainRange> chains_;
+  mutable std::vector<ResidueRange> residues_; //!< residue index
+  //! index is out of date with respect to atoms_ or matrix_
+  mutable std::atomic<bool> stale_;
   //! Atom filter function
   const std::function<bool(const libpdb::PDB &)> filter_;
 
 public:
-  PDB(); //!< Constructor
-  PDB(const PDB &p); //!< Copy constructor
+  PDBT(); //!< Constructor
+  PDBT(const PDBT &p); //!< Copy constructor
   /**
    * @brief Constructor
    * @param filename PDB file name to read from
    * @param filter filter function for ATOM/HETATM records
    */
-  PDB(const std::string &filename,
-      std::function<bool(const libpdb::PDB &)> filter =
-          [](const libpdb::PDB &) { return true; });
+  PDBT(const std::string &filename,
+       std::function<bool(const libpdb::PDB &)> filter =
+           [](const libpdb::PDB &) { return true; });
+  /**
+   * @brief Constructor
+   * @param filename PDB file name to read from
+   * @param selection selection of ATOM/HETATM records; evaluated once all
+   *        records have been read
+   */
+  PDBT(const std::string &filename, const Selection &selection);
   /**
    * @brief Assignement operator
    * @param p other PDB object
    * @return reference to *this, updated from p
    */
-  PDB &operator=(const PDB &p);
+  PDBT &operator=(const PDBT &p);
   //! get coordinate matrix
   const Matrix &matrix() const;
-  //! set coordinate matrix
+  //! set coordinate matrix (records are updated when next accessed)
   const Matrix &setMatrix(const Matrix &m);
+  //! set coordinate matrix, taking ownership of m
+  const Matrix &setMatrix(Matrix &&m);
   //! get models
   const std::vector<Model> &models() const;
   //! get number of models
@@ -129,6 +219,10 @@ public:
   void append(const Record &, const int model = 0);
   //! get centroid (i.e. mean x, y, z) of strcuture
   Coord centroid() const;
+  //! get chains, in order of appearance (see ChainRange)
+  const std::vector<ChainRange> &chains() const;
+  //! get residues, in order of appearance (see ResidueRange)
+  const std::vector<ResidueRange> &residues() const;
 };
 
 // output stream representation of RecordCoord
@@ -147,8 +241,10 @@ inline std::ostream &operator<<(std::ostream &s, const RecordCoord &c) {
 /**
  * @brief Model, a sub-PDB structure
  */
-class Model : public PDB {
+template <typename T> class ModelT : public PDBT<T> {
 private:
+  typedef typename PDBT<T>::Model Model;
+  typedef typename PDBT<T>::Record Record;
   //! a Model cannot itself have more models
   const std::vector<Model> &models() const = delete;
   //! a Model contains only atom records
@@ -158,7 +254,16 @@ private:
 
 public:
   int modelNum() const { return modelNum_; }
-  friend void PDB::append(const Record &r, const int model);
+  friend void PDBT<T>::append(const Record &r, const int model);
 };
 
+//! PDB with double precision coordinates
+typedef PDBT<double> PDB;
+//! PDB with single precision coordinates
+typedef PDBT<float> PDBf;
+//! Model with double precision coordinates
+typedef ModelT<double> Model;
+//! Model with single precision coordinates
+typedef ModelT<float> Modelf;
+
 } // namespace zdock
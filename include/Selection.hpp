@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Exception.hpp"
+#include "pdb++.h"
+#include <Eigen/Dense>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Column-wise view of ATOM/HETATM records
+ *
+ * Atom and residue names are stored trimmed and packed into 32-bit codes so
+ * that selections compare integers rather than (temporary) strings.
+ */
+class AtomTable {
+public:
+  //! coordinate matrix type
+  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+  //! atom flags
+  enum Flags : uint8_t { HETATM = 1, HYDROGEN = 2 };
+
+  std::vector<char> chain;       //!< chain identifiers
+  std::vector<int> resSeq;       //!< residue sequence numbers
+  std::vector<uint32_t> name;    //!< packed atom names
+  std::vector<uint32_t> resName; //!< packed residue names
+  std::vector<uint32_t> element; //!< packed element symbols
+  std::vector<uint8_t> flags;    //!< HETATM / HYDROGEN flags
+  Matrix xyz;                    //!< atom coordinates
+
+  /**
+   * @brief Constructor
+   *
+   * @param atoms ATOM/HETATM records
+   */
+  AtomTable(const std::vector<std::shared_ptr<libpdb::PDB>> &atoms);
+
+  //! number of atoms
+  size_t size() const { return chain.size(); }
+
+  /**
+   * @brief Pack up to four characters of a name, ignoring whitespace
+   *
+   * @param s (fixed width) name
+   * @param n maximum number of characters to read
+   * @return packed name
+   */
+  static uint32_t pack(const char *s, const size_t n = 4);
+};
+
+/**
+ * @brief Compiled atom selection expression
+ *
+ * Supported grammar (keywords are lower case; 'and' binds tighter than
+ * 'or'):
+ *
+ *     expr    := term ('or' term)*
+ *     term    := factor ('and' factor)*
+ *     factor  := 'not' factor | '(' expr ')' | 'within' <dist> 'of' factor
+ *              | 'all' | 'none' | 'hydrogen' | 'hetatm'
+ *              | 'chain' <id>+ | 'name' <name>+ | 'resn' <name>+
+ *              | 'element' <symbol>+ | 'resi' <num>[-<num>]+
+ *
+ * e.g. "chain A and resi 10-50 and name CA", "not hydrogen",
+ * "within 10 of chain B".
+ */
+class Selection {
+private:
+  //! node types of the expression tree
+  enum Type {
+    ALL,
+    NONE,
+    HYDROGEN,
+    HETATM,
+    CHAIN,
+    NAME,
+    RESN,
+    ELEMENT,
+    RESI,
+    NOT,
+    AND,
+    OR,
+    WITHIN
+  };
+  //! expression tree node
+  struct Node {
+    Type type;                              //!< node type
+    std::vector<uint32_t> values;           //!< names / chain ids
+    std::vector<std::pair<int, int>> range; //!< residue ranges
+    double distance;                        //!< 'within' distance
+    int lhs, rhs;                           //!< operand nodes
+  };
+
+  std::string expr_;        //!< source expression
+  std::vector<Node> nodes_; //!< compiled expression tree
+  int root_;                //!< root node
+
+  // parser
+  int parseOr_(const std::vector<std::string> &t, size_t &i);
+  int parseAnd_(const std::vector<std::string> &t, size_t &i);
+  int parseFactor_(const std::vector<std::string> &t, size_t &i);
+  int node_(const Type type, const int lhs = -1, const int rhs = -1);
+
+  // evaluate node over table
+  void eval_(const int node, const AtomTable &t, std::vector<char> &m) const;
+
+public:
+  /**
+   * @brief Constructor; compiles the expression
+   *
+   * @param expr selection expression (defaults to all atoms)
+   */
+  Selection(const std::string &expr = "all");
+  /**
+   * @brief Evaluate selection over all atoms in a table
+   *
+   * @param t atom table
+   * @return mask with one entry per atom (non-zero if selected)
+   */
+  std::vector<char> mask(const AtomTable &t) const;
+  /**
+   * @brief Test whether this selection trivially selects every atom
+   *
+   * @return true if expression is 'all'
+   */
+  bool isall() const { return ALL == nodes_[root_].type; }
+  /**
+   * @brief Get selection expression
+   *
+   * @return expression string
+   */
+  const std::string &expression() const { return expr_; }
+};
+
+} // namespace zdock
@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <istream>
 #include <string>
 #include <vector>
 
@@ -139,11 +140,31 @@ private:
   //! (M-)ZDOCK file name
   const std::string filename_;
 
+  //! current line number (streaming)
+  int linenum_;
+  //! prediction format (ismzdock_) set by the first prediction
+  bool hasformat_;
+
   // private methods
   /**
    * @brief read from (M-)ZDOCK output file
    */
   void read_();
+  /**
+   * @brief read from (M-)ZDOCK output stream
+   *
+   * @param in input stream
+   * @param stream stop after the first prediction
+   */
+  void read_(std::istream &in, const bool stream);
+  /**
+   * @brief parse one prediction line
+   *
+   * @param line input line
+   * @param p prediction, set if line is a prediction
+   * @return true if line is a prediction
+   */
+  bool parse_(const std::string &line, Prediction &p);
 
 public:
   /**
@@ -152,6 +173,25 @@ public:
    * @param fn (M-)ZDOCK output file name
    */
   ZDOCK(const std::string &fn);
+  /**
+   * @brief Constructor; read header from a stream
+   *
+   * Only the header and the first prediction are read, so that predictions
+   * can be consumed one at a time with next() as they arrive.
+   *
+   * @param in input stream, positioned at the start of (M-)ZDOCK output
+   * @param fn file name used in messages and to locate structures
+   */
+  ZDOCK(std::istream &in, const std::string &fn = "-");
+
+  /**
+   * @brief Read the next prediction from a stream
+   *
+   * @param in input stream, as passed to ZDOCK(std::istream &, ...)
+   * @param p next prediction
+   * @return false at end of stream
+   */
+  bool next(std::istream &in, Prediction &p);
 
   // simple getters
   /**
@@ -25,7 +25,8 @@
  */
 
 #include "Centroids.hpp"
-#include "TransformLigand.cpp"
+#include "Metrics.hpp"
+#include "TransformLigand.hpp"
 #include "Utils.hpp"
 #include "ZDOCK.hpp"
 #include <cmath>
@@ -36,8 +37,10 @@ namespace e = Eigen;
 
 namespace zdock {
 Centroids::Centroids(const std::string &zdockoutput, const std::string &ligand,
-                     const size_t n, const std::string &chain)
-    : zdockfn_(zdockoutput), ligandfn_(ligand), chain_(chain), n_(n) {}
+                     const size_t n, const std::string &chain,
+                     const std::string &selection)
+    : zdockfn_(zdockoutput), ligandfn_(ligand), chain_(chain), n_(n),
+      selection_(selection) {}
 
 void Centroids::doCentroids() {
   std::string ligfn; // ligand file name
@@ -59,13 +62,20 @@ void Centroids::doCentroids() {
   }
 
   // load ligand
-  PDB lig(ligfn), out;
+  PDB lig(ligfn, selection_), out;
+  if (!lig.matrix().cols()) {
+    throw CentroidsException("No atoms selected by '" +
+                             selection_.expression() + "'");
+  }
   p::PDB x(p::PDB::HETATM);
   const TransformLigand txl(z);
   const e::Vector3d v = lig.centroid();
+  TransformLigand::Matrix poses(3, n_);
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("centroids", n_);
+  txl.txLigandBatch(v, z.predictions(), 0, n_, poses);
   for (size_t i = 0; i < n_; ++i) {
-    const zdock::Prediction &pred = z.predictions()[i];
-    e::Vector3d pose = txl.txLigand(v, pred);
+    const e::Vector3d pose = poses.col(i);
     x.atom = templateAtom_;
     x.atom.serialNum = static_cast<int>(i) + 1;
     x.atom.residue.chainId = chain_.c_str()[0];
@@ -78,6 +88,7 @@ void Centroids::doCentroids() {
   for (const auto &x : out.atoms()) {
     std::cout << *x << '\n';
   }
+  metrics.end(n_);
 }
 
 void usage(const std::string &cmd, const std::string &err = "") {
@@ -91,6 +102,10 @@ void usage(const std::string &cmd, const std::string &err = "") {
                "(defaults to 1; the top prediction)\n"
             << "  -l <filename>   ligand PDB filename; defaults to receptor in ZDOCK output\n"
             << "  -c <char>       chain id to use for output (defaults to 'Z')\n"
+            << "  -s <selection>  ligand atoms used for centroids (defaults to "
+               "all)\n"
+            << "  -P <fd|file>    write progress metrics as JSON lines to a "
+               "file descriptor (number) or file\n"
             << std::endl;
 }
 
@@ -99,9 +114,11 @@ void usage(const std::string &cmd, const std::string &err = "") {
 int main(int argc, char *argv[]) {
   std::string zdockfn, ligfn;
   std::string chain("Z");
+  std::string selection = "all";
+  std::string metricsfn; // progress metrics target
   int n = 1;
   int c;
-  while ((c = getopt(argc, argv, "hn:l:c:")) != -1) {
+  while ((c = getopt(argc, argv, "hn:l:c:s:P:")) != -1) {
     switch (c) {
     case 'c':
       chain = std::string(optarg)[0];
@@ -112,6 +129,12 @@ int main(int argc, char *argv[]) {
     case 'l':
       ligfn = optarg;
       break;
+    case 's':
+      selection = optarg;
+      break;
+    case 'P':
+      metricsfn = optarg;
+      break;
     case 'h': // usage
       zdock::usage(argv[0]);
       return 0;
@@ -130,7 +153,10 @@ int main(int argc, char *argv[]) {
   }
   try {
     const auto t1 = zdock::Utils::tic();
-    zdock::Centroids ct(zdockfn, ligfn, n, chain);
+    if ("" != metricsfn) {
+      zdock::Metrics::instance().open(metricsfn);
+    }
+    zdock::Centroids ct(zdockfn, ligfn, n, chain, selection);
     ct.doCentroids();
     std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec" << std::endl;
   } catch (const zdock::Exception &e) {
@@ -28,6 +28,7 @@
 
 #include "Exception.hpp"
 #include "PDB.hpp"
+#include "Selection.hpp"
 #include <string>
 
 namespace zdock {
@@ -53,6 +54,10 @@ private:
    * @brief top-N centroids are produced
    */
   size_t n_;
+  /**
+   * @brief Selection of ligand atoms contributing to the centroid
+   */
+  const Selection selection_;
   /**
    * @brief Template ATOM for centroids
    */
@@ -87,9 +92,11 @@ public:
    * @param ligand Ligand PDB file name
    * @param n Top-N centroids are produced
    * @param chain Chain ID to use for output
+   * @param selection Selection of ligand atoms contributing to the centroid
    */
   Centroids(const std::string &zdockoutput, const std::string &ligand,
-            const size_t n, const std::string &chain);
+            const size_t n, const std::string &chain,
+            const std::string &selection = "all");
   /**
    * @brief Actually perform centroids generation
    */
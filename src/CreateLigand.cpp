@@ -37,9 +37,10 @@ namespace zdock {
 CreateLigand::CreateLigand(const std::string &zdockoutput,
                            const std::string &ligand,
                            const std::string &receptor, const size_t n,
-                           const bool cmplx, const bool allrecords)
+                           const bool cmplx, const bool allrecords,
+                           const std::string &selection)
     : zdockfn_(zdockoutput), ligandfn_(ligand), receptorfn_(receptor), n_(n),
-      complex_(cmplx), allrecords_(allrecords) {}
+      complex_(cmplx), allrecords_(allrecords), selection_(selection) {}
 
 void CreateLigand::doCreate() {
   std::string ligfn; // ligand file name
@@ -61,7 +62,7 @@ void CreateLigand::doCreate() {
   }
 
   // load ligand
-  PDB lig(ligfn);
+  PDB lig(ligfn, selection_);
   PDB rec;
   TransformLigand t(z);
   lig.setMatrix(t.txLigand(lig.matrix(), pred));
@@ -73,7 +74,7 @@ void CreateLigand::doCreate() {
     } else {
       recfn = receptorfn_;
     }
-    rec = PDB(recfn);
+    rec = PDB(recfn, selection_);
   }
 
   for (const auto &x : (allrecords_ ? lig.records() : lig.atoms())) {
@@ -104,6 +105,7 @@ void usage(const std::string &cmd, const std::string &err = "") {
          "ZDOCK output\n"
       << "  -a              return all records (by default only ATOM and "
          "HETATM are returned)\n"
+      << "  -s <selection>  only output selected ATOM/HETATM records\n"
 
       << std::endl;
 }
@@ -112,11 +114,12 @@ void usage(const std::string &cmd, const std::string &err = "") {
 
 int main(int argc, char *argv[]) {
   std::string zdockfn, ligfn, recfn;
+  std::string selection = "all";
   size_t n = 1;
   int c;
   bool cmplx = false;
   bool allrecords = false;
-  while ((c = getopt(argc, argv, "achn:l:r:")) != -1) {
+  while ((c = getopt(argc, argv, "achn:l:r:s:")) != -1) {
     switch (c) {
     case 'a':
       allrecords = true;
@@ -133,6 +136,9 @@ int main(int argc, char *argv[]) {
     case 'r': // alternative ligand
       recfn = optarg;
       break;
+    case 's': // atom selection
+      selection = optarg;
+      break;
     case 'h': // usage
       zdock::usage(argv[0]);
       return 0;
@@ -150,7 +156,8 @@ int main(int argc, char *argv[]) {
     return 1;
   }
   try {
-    zdock::CreateLigand c(zdockfn, ligfn, recfn, n, cmplx, allrecords);
+    zdock::CreateLigand c(zdockfn, ligfn, recfn, n, cmplx, allrecords,
+                         selection);
     c.doCreate();
   } catch (const zdock::Exception &e) {
     // something went wrong
@@ -27,6 +27,7 @@
 #pragma once
 
 #include "Exception.hpp"
+#include "Selection.hpp"
 #include "ZDOCK.hpp"
 
 namespace zdock {
@@ -60,6 +61,10 @@ private:
    * @brief Toggle return of all input PDB records vs only ATOM/HETATM records
    */
   const bool allrecords_;
+  /**
+   * @brief Selection of ATOM/HETATM records to transform and output
+   */
+  const Selection selection_;
 
 public:
   /**
@@ -71,10 +76,11 @@ public:
    * @param n Prediction number in ZDOCK file (1-based)
    * @param cmplx Toggle generation of full complex
    * @param allrecords Toggle return of all input PDB records
+   * @param selection Selection of ATOM/HETATM records
    */
   CreateLigand(const std::string &zdockoutput, const std::string &ligand,
                const std::string &receptor, const size_t n, const bool cmplx,
-               const bool allrecords);
+               const bool allrecords, const std::string &selection = "all");
   /**
    * @brief Actually perform generation of ligand/complex
    */
@@ -36,9 +36,10 @@ namespace zdock {
 
 CreateMultimer::CreateMultimer(const std::string &zdockoutput,
                                const std::string &structure, const size_t n,
-                               const int mer, const bool allrecords)
+                               const int mer, const bool allrecords,
+                               const std::string &selection)
     : zdockfn_(zdockoutput), structurefn_(structure), n_(n), mer_(mer),
-      allrecords_(allrecords) {}
+      allrecords_(allrecords), selection_(selection) {}
 
 void CreateMultimer::doCreate() {
   std::string recfn; // structure file name
@@ -68,7 +69,7 @@ void CreateMultimer::doCreate() {
   }
 
   // load structure
-  PDB rec(recfn);
+  PDB rec(recfn, selection_);
   TransformMultimer t(z);
   const auto m = rec.matrix();
   if (-1 == mer_) {
@@ -115,6 +116,7 @@ void usage(const std::string &cmd, const std::string &err = "") {
                "specified)\n"
             << "  -a              return all records (by default only ATOM and "
                "HETATM are returned)\n"
+            << "  -s <selection>  only output selected ATOM/HETATM records\n"
             << std::endl;
 }
 
@@ -122,11 +124,12 @@ void usage(const std::string &cmd, const std::string &err = "") {
 
 int main(int argc, char *argv[]) {
   std::string zdockfn, recfn;
+  std::string selection = "all";
   bool allrecords = false;
   size_t n = 1;
   int m = -1;
   int c;
-  while ((c = getopt(argc, argv, "ahn:r:m:")) != -1) {
+  while ((c = getopt(argc, argv, "ahn:r:m:s:")) != -1) {
     switch (c) {
     case 'a':
       allrecords = true;
@@ -140,6 +143,9 @@ int main(int argc, char *argv[]) {
     case 'r': // alternative ligand
       recfn = optarg;
       break;
+    case 's': // atom selection
+      selection = optarg;
+      break;
     case 'h': // usage
       zdock::usage(argv[0]);
       return 0;
@@ -157,7 +163,7 @@ int main(int argc, char *argv[]) {
     return 1;
   }
   try {
-    zdock::CreateMultimer c(zdockfn, recfn, n, m, allrecords);
+    zdock::CreateMultimer c(zdockfn, recfn, n, m, allrecords, selection);
     c.doCreate();
   } catch (const zdock::Exception &e) {
     // something went wrong
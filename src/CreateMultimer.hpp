@@ -27,6 +27,7 @@
 #pragma once
 
 #include "Exception.hpp"
+#include "Selection.hpp"
 #include "ZDOCK.hpp"
 
 namespace zdock {
@@ -56,6 +57,10 @@ private:
    * @brief Toggle whether to return all PDB records rather than just ATOM/HETATM
    */
   const bool allrecords_;
+  /**
+   * @brief Selection of ATOM/HETATM records to transform and output
+   */
+  const Selection selection_;
 
 public:
   /**
@@ -66,9 +71,11 @@ public:
    * @param n Prediction number in M-ZDOCK output file (1-based)
    * @param mer Component number if single component required
    * @param allrecords Toggle whether to return all PDB records rather than just ATOM/HETATM
+   * @param selection Selection of ATOM/HETATM records
    */
   CreateMultimer(const std::string &zdockoutput, const std::string &structure,
-                 const size_t n, const int mer, const bool allrecords);
+                 const size_t n, const int mer, const bool allrecords,
+                 const std::string &selection = "all");
   /**
    * @brief Actually perform multimer creation
    */
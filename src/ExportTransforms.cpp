@@ -0,0 +1,195 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ExportTransforms.hpp"
+#include "TransformLigand.hpp"
+#include "TransformMultimer.hpp"
+#include "Utils.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace e = Eigen;
+
+namespace zdock {
+
+ExportTransforms::ExportTransforms(const std::string &zdockfn, const size_t n,
+                                   const bool quaternion, const bool binary)
+    : zdockfn_(zdockfn), n_(n), quaternion_(quaternion), binary_(binary) {}
+
+void ExportTransforms::write(std::ostream &os) const {
+  const ZDOCK z(zdockfn_);
+  const auto &preds = z.predictions();
+  const size_t n = (n_ ? std::min(n_, preds.size()) : preds.size());
+  const uint32_t width = quaternion_ ? 7 : 12;
+
+  // transformations; prediction major, one per mer for M-ZDOCK
+  std::vector<TransformUtil::Transforms> tx;
+  if (z.ismzdock()) {
+    const TransformMultimer txm(z);
+    for (int i = 0; i < txm.symmetry(); ++i) {
+      tx.push_back(txm.transforms(preds, 0, n, i));
+    }
+  } else {
+    const TransformLigand txl(z);
+    tx.push_back(txl.transforms(preds, 0, n));
+  }
+  const uint32_t nmers = tx.size();
+
+  if (binary_) {
+    const uint32_t version = 1;
+    const uint64_t npreds = n;
+    os.write("ZDTX", 4);
+    os.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    os.write(reinterpret_cast<const char *>(&width), sizeof(width));
+    os.write(reinterpret_cast<const char *>(&nmers), sizeof(nmers));
+    os.write(reinterpret_cast<const char *>(&npreds), sizeof(npreds));
+  }
+
+  double row[12];
+  char buf[32];
+  for (size_t i = 0; i < n; ++i) {
+    for (uint32_t m = 0; m < nmers; ++m) {
+      const auto &t = tx[m][i];
+      if (quaternion_) {
+        e::Quaterniond q(t.linear());
+        if (q.w() < 0) {
+          q.coeffs() = -q.coeffs(); // canonical; w >= 0
+        }
+        row[0] = q.w();
+        row[1] = q.x();
+        row[2] = q.y();
+        row[3] = q.z();
+        row[4] = t.translation()(0);
+        row[5] = t.translation()(1);
+        row[6] = t.translation()(2);
+      } else {
+        for (int r = 0; r < 3; ++r) {
+          for (int c = 0; c < 4; ++c) {
+            row[4 * r + c] = t.matrix()(r, c);
+          }
+        }
+      }
+      if (binary_) {
+        os.write(reinterpret_cast<const char *>(row), width * sizeof(double));
+      } else {
+        // prediction (and mer) numbers are 1-based
+        os << i + 1;
+        if (z.ismzdock()) {
+          os << '\t' << m + 1;
+        }
+        for (uint32_t k = 0; k < width; ++k) {
+          std::snprintf(buf, sizeof(buf), "\t%.9g", row[k]);
+          os << buf;
+        }
+        os << '\n';
+      }
+    }
+  }
+  os.flush();
+  if (!os) {
+    throw ExportTransformsException("Error writing output");
+  }
+}
+
+void usage(const std::string &cmd, const std::string &err = "") {
+  // print error if any
+  if ("" != err) {
+    std::cerr << "Error: " << err << std::endl << std::endl;
+  }
+  // print usage
+  std::cerr
+      << "usage: " << cmd << " [options] <zdock output>\n\n"
+      << "  -n <integer>    number of predictions (top-n) (defaults to all)\n"
+      << "  -q              quaternion (w, x, y, z) plus translation, rather\n"
+      << "                  than 3x4 matrix\n"
+      << "  -b              binary output\n"
+      << "  -o <filename>   output file name (defaults to stdout)\n"
+      << std::endl;
+}
+
+} // namespace zdock
+
+int main(int argc, char *argv[]) {
+  std::string zdockfn, outfn;
+  bool quaternion = false, binary = false;
+  int n = 0;
+  int c;
+  while ((c = getopt(argc, argv, "hn:qbo:")) != -1) {
+    switch (c) {
+    case 'n':
+      n = std::stoi(optarg);
+      break;
+    case 'q':
+      quaternion = true;
+      break;
+    case 'b':
+      binary = true;
+      break;
+    case 'o':
+      outfn = optarg;
+      break;
+    case 'h': // usage
+      zdock::usage(argv[0]);
+      return 0;
+    case '?':
+      zdock::usage(argv[0]);
+      return 1;
+    default:
+      return 1;
+    }
+  }
+  if (argc > optind) {
+    zdockfn = argv[optind]; // zdock file
+  } else {
+    zdock::usage(argv[0], "No ZDOCK output file specified.");
+    return 1;
+  }
+  if (n < 0) {
+    zdock::usage(argv[0], "Invalid number of predictions.");
+    return 1;
+  }
+  try {
+    const auto t1 = zdock::Utils::tic();
+    const zdock::ExportTransforms x(zdockfn, n, quaternion, binary);
+    if ("" == outfn) {
+      x.write(std::cout);
+    } else {
+      std::ofstream f(outfn, std::ios::binary);
+      if (!f.is_open()) {
+        throw zdock::ExportTransformsException("Error opening output file '" +
+                                               outfn + "'.");
+      }
+      x.write(f);
+    }
+    std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec" << std::endl;
+  } catch (const zdock::Exception &e) {
+    // something went wrong
+    zdock::usage(argv[0], e.what());
+    return 1;
+  }
+}
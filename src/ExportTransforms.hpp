@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Exception.hpp"
+#include "ZDOCK.hpp"
+#include <iostream>
+#include <string>
+
+namespace zdock {
+
+/**
+ * @brief Write the rigid-body transformation of each (M-)ZDOCK prediction
+ *
+ * Each row holds either a 3x4 matrix (row-major; rotation with translation
+ * in the last column) or a unit quaternion (w, x, y, z; w >= 0) followed by
+ * the translation. For M-ZDOCK, one row is written for each mer of each
+ * prediction.
+ *
+ * Binary output starts with a header (magic "ZDTX", uint32 version, uint32
+ * row width, uint32 number of mers, uint64 number of predictions) followed
+ * by the rows as native-endian doubles.
+ */
+class ExportTransforms {
+private:
+  const std::string zdockfn_; //!< zdock file name
+  const size_t n_;            //!< top-n predictions (0 for all)
+  const bool quaternion_;     //!< quaternion rather than matrix rows
+  const bool binary_;         //!< binary rather than text output
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param zdockfn (M-)ZDOCK file name
+   * @param n number of predictions to export (0 for all)
+   * @param quaternion write quaternion plus translation
+   * @param binary write binary output
+   */
+  ExportTransforms(const std::string &zdockfn, const size_t n = 0,
+                   const bool quaternion = false, const bool binary = false);
+  /**
+   * @brief Write transformations
+   *
+   * @param os output stream
+   */
+  void write(std::ostream &os) const;
+};
+
+/**
+ * @brief General exception in ExportTransforms
+ */
+class ExportTransformsException : public Exception {
+public:
+  ExportTransformsException(const std::string &msg) : Exception(msg) {}
+};
+
+} // namespace zdock
@@ -25,7 +25,10 @@
  */
 
 #include "FilterConstraints.hpp"
+#include "Metrics.hpp"
+#include "Parallel.hpp"
 #include "Utils.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
@@ -39,9 +42,11 @@ namespace zdock {
 FilterConstraints::FilterConstraints(const std::string &zdockoutput,
                                      const std::string &constraints,
                                      const std::string &receptorpdb,
-                                     const std::string &ligandpdb)
+                                     const std::string &ligandpdb,
+                                     const std::string &selection,
+                                     const size_t nthreads)
     : zdock_(zdockoutput), txl_(zdockoutput), txm_(zdockoutput),
-      confn_(constraints) {
+      confn_(constraints), selection_(selection), nthreads_(nthreads) {
   // receptor file name
   if ("" == receptorpdb) {
     recfn_ = Utils::copath(zdockoutput, zdock_.receptor().filename);
@@ -58,16 +63,39 @@ FilterConstraints::FilterConstraints(const std::string &zdockoutput,
   }
 }
 
+// assess predictions [0, n) on a thread pool, in blocks so progress is
+// reported between pool loops; fn(begin, end, flags) sets flags[k] for k in
+// [begin, end)
+template <typename F>
+static std::vector<char> assess(const size_t n, const size_t nthreads,
+                                F &&fn) {
+  Metrics &metrics = Metrics::instance();
+  ThreadPool pool(nthreads);
+  std::vector<char> keep(n, 0);
+  const size_t block = 16384;
+  const size_t chunk = 256;
+  metrics.stage("filter", n);
+  for (size_t begin = 0; begin < n; begin += block) {
+    const size_t end = std::min(n, begin + block);
+    pool.run(end - begin, chunk, [&](size_t b, size_t e) {
+      fn(begin + b, begin + e, keep);
+    });
+    metrics.progress(end);
+  }
+  metrics.end(n);
+  return keep;
+}
+
 // m-zdock
 void FilterConstraints::filterMZDOCKConstraints_() {
   // load constraints file
   Constraints ccc(confn_);
 
   // load full PDB files
-  PDB structure(recfn_);
+  PDBf structure(recfn_, selection_);
 
   // grab atoms for valid constraints
-  PDB s0, s1, s2;
+  PDBf s0, s1, s2;
   std::vector<double> mindist;
   std::vector<double> maxdist;
   if (!ccc.constraints().size()) {
@@ -79,9 +107,9 @@ void FilterConstraints::filterMZDOCKConstraints_() {
     try {
       // these throw exceptions for bad constraints; we want to append
       // both_ l and r or _none_.
-      const PDB::Record r1 = structure[x.recCoord];
-      const PDB::Record r2 = structure[x.ligCoord]; // two copies
-      const PDB::Record r3 = structure[x.ligCoord]; // two copies
+      const PDBf::Record r1 = structure[x.recCoord];
+      const PDBf::Record r2 = structure[x.ligCoord]; // two copies
+      const PDBf::Record r3 = structure[x.ligCoord]; // two copies
       s0.append(r2);                                // one side
       s1.append(r1);                                // original
       s2.append(r3);                                // other side
@@ -102,27 +130,42 @@ void FilterConstraints::filterMZDOCKConstraints_() {
   const auto v = zdock_.predictions(); // our copy
   auto &preds = zdock_.predictions();  // our ref
   preds.clear();
-  e::Matrix<double, 2, e::Dynamic> m;
-  m.resize(2, ccc.constraints().size());
-  for (const Prediction &p : v) {
-    // compare poses p0 and p2 to pose p1 ("middle" structure)
-    FilterConstraints::Matrix p0 = txm_.txMultimer(s0.matrix(), p, 0);
-    FilterConstraints::Matrix p1 = txm_.txMultimer(s1.matrix(), p, 1);
-    FilterConstraints::Matrix p2 = txm_.txMultimer(s2.matrix(), p, 2);
-    // row 0: dist p1 -> p0; row 1: dist p1 -> p2
-    m << (p1 - p0.matrix()).colwise().squaredNorm().array().sqrt().matrix(),
-        (p1 - p2.matrix()).colwise().squaredNorm().array().sqrt().matrix();
-    bool accepted = true;
-    for (size_t i = 0; i < n; ++i) {
-      // actual filtering
-      if (std::min<double>(m(0, i), m(1, i)) > maxdist[i] ||
-          std::min<double>(m(0, i), m(1, i)) < mindist[i]) {
-        accepted = false;
-        break;
+  // pose k is structure k
+  const SoA<float> a0(s0.matrix()), a1(s1.matrix()), a2(s2.matrix());
+  SoA<float> q0(n, v.size()), q1(n, v.size()), q2(n, v.size());
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("poses", v.size());
+  txm_.txMultimerBatch(a0, v, 0, v.size(), 0, q0, nthreads_);
+  txm_.txMultimerBatch(a1, v, 0, v.size(), 1, q1, nthreads_);
+  txm_.txMultimerBatch(a2, v, 0, v.size(), 2, q2, nthreads_);
+  metrics.end(v.size());
+  const auto keep = assess(v.size(), nthreads_, [&](const size_t begin,
+                                                    const size_t end,
+                                                    std::vector<char> &flags) {
+    // per-thread scratch
+    static thread_local std::vector<float> d0, d1;
+    d0.resize(n);
+    d1.resize(n);
+    for (size_t k = begin; k < end; ++k) {
+      // compare poses p0 and p2 to pose p1 ("middle" structure)
+      Simd::distance2(q1, k, q0, k, &d0[0]);
+      Simd::distance2(q1, k, q2, k, &d1[0]);
+      bool accepted = true;
+      for (size_t i = 0; i < n; ++i) {
+        // actual filtering
+        const double m = std::min<double>(std::sqrt(d0[i]), std::sqrt(d1[i]));
+        if (m > maxdist[i] || m < mindist[i]) {
+          accepted = false;
+          break;
+        }
       }
+      flags[k] = accepted;
     }
-    if (accepted) {
-      preds.push_back(p);
+  });
+  // accepted predictions in their original order
+  for (size_t k = 0; k < v.size(); ++k) {
+    if (keep[k]) {
+      preds.push_back(v[k]);
     }
   }
 }
@@ -133,11 +176,11 @@ void FilterConstraints::filterZDOCKConstraints_() {
   Constraints ccc(confn_);
 
   // load full PDB files
-  PDB receptor(recfn_);
-  PDB ligand(ligfn_);
+  PDBf receptor(recfn_, selection_);
+  PDBf ligand(ligfn_, selection_);
 
   // grab atoms for valid constraints
-  PDB ligatoms, recatoms;
+  PDBf ligatoms, recatoms;
   std::vector<double> mindist;
   std::vector<double> maxdist;
   if (!ccc.constraints().size()) {
@@ -149,8 +192,8 @@ void FilterConstraints::filterZDOCKConstraints_() {
     try {
       // these throw exceptions for bad constraints; we want to append
       // both_ l and r or _none_.
-      const PDB::Record r = receptor[x.recCoord];
-      const PDB::Record l = ligand[x.ligCoord];
+      const PDBf::Record r = receptor[x.recCoord];
+      const PDBf::Record l = ligand[x.ligCoord];
       recatoms.append(r);
       ligatoms.append(l);
       if (Constraint::MAX == x.constraintType) {
@@ -170,20 +213,37 @@ void FilterConstraints::filterZDOCKConstraints_() {
   const auto v = zdock_.predictions(); // our copy
   auto &preds = zdock_.predictions();  // our ref
   preds.clear();
-  for (const Prediction &p : v) {
-    FilterConstraints::Matrix pose = txl_.txLigand(ligatoms.matrix(), p);
-    e::Matrix<double, 1, e::Dynamic> m =
-        (pose - recatoms.matrix()).colwise().squaredNorm().array().sqrt();
-    bool accepted = true;
-    for (size_t i = 0; i < n; ++i) {
-      // actual filtering
-      if (m(0, i) > maxdist[i] || m(0, i) < mindist[i]) {
-        accepted = false;
-        break;
+  // pose k is structure k
+  const SoA<float> lig(ligatoms.matrix()), rec(recatoms.matrix());
+  SoA<float> poses(n, v.size());
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("poses", v.size());
+  txl_.txLigandBatch(lig, v, 0, v.size(), poses, nthreads_);
+  metrics.end(v.size());
+  const auto keep = assess(v.size(), nthreads_, [&](const size_t begin,
+                                                    const size_t end,
+                                                    std::vector<char> &flags) {
+    // per-thread scratch
+    static thread_local std::vector<float> d;
+    d.resize(n);
+    for (size_t k = begin; k < end; ++k) {
+      Simd::distance2(poses, k, rec, 0, &d[0]);
+      bool accepted = true;
+      for (size_t i = 0; i < n; ++i) {
+        // actual filtering
+        const float m = std::sqrt(d[i]);
+        if (m > maxdist[i] || m < mindist[i]) {
+          accepted = false;
+          break;
+        }
       }
+      flags[k] = accepted;
     }
-    if (accepted) {
-      preds.push_back(p);
+  });
+  // accepted predictions in their original order
+  for (size_t k = 0; k < v.size(); ++k) {
+    if (keep[k]) {
+      preds.push_back(v[k]);
     }
   }
 }
@@ -210,6 +270,11 @@ void usage(const std::string &cmd, const std::string &err = "") {
                "in (M-)ZDOCK output\n"
             << "  -l <filename>   ligand PDB filename; defaults to ligand in "
                "ZDOCK output\n"
+            << "  -s <selection>  atoms eligible for constraints (defaults to "
+               "all)\n"
+            << "  -j <integer>    number of threads (defaults to all cores)\n"
+            << "  -P <fd|file>    write progress metrics as JSON lines to a "
+               "file descriptor (number) or file\n"
             << std::endl;
 }
 
@@ -217,8 +282,11 @@ void usage(const std::string &cmd, const std::string &err = "") {
 
 int main(int argc, char *argv[]) {
   std::string zdockfn, confn, recfn, ligfn;
+  std::string selection = "all";
+  std::string metricsfn; // progress metrics target
+  int nthreads = 0;
   int c;
-  while ((c = getopt(argc, argv, "hr:l:")) != -1) {
+  while ((c = getopt(argc, argv, "hr:l:s:j:P:")) != -1) {
     switch (c) {
     case 'r':
       recfn = optarg;
@@ -226,6 +294,15 @@ int main(int argc, char *argv[]) {
     case 'l':
       ligfn = optarg;
       break;
+    case 's':
+      selection = optarg;
+      break;
+    case 'j':
+      nthreads = std::stoi(optarg);
+      break;
+    case 'P':
+      metricsfn = optarg;
+      break;
     case 'h': // usage
       zdock::usage(argv[0]);
       return 0;
@@ -247,9 +324,17 @@ int main(int argc, char *argv[]) {
     }
     return 1;
   }
+  if (nthreads < 0) {
+    zdock::usage(argv[0], "Invalid number of threads.");
+    return 1;
+  }
   try {
     const auto t1 = zdock::Utils::tic();
-    zdock::FilterConstraints p(zdockfn, confn, recfn, ligfn);
+    if ("" != metricsfn) {
+      zdock::Metrics::instance().open(metricsfn);
+    }
+    zdock::FilterConstraints p(zdockfn, confn, recfn, ligfn, selection,
+                               nthreads);
     p.filter();
     std::cout << p.zdock() << std::endl;
     std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec" << std::endl;
@@ -28,6 +28,7 @@
 
 #include "Constraints.hpp"
 #include "PDB.hpp"
+#include "Selection.hpp"
 #include "TransformLigand.hpp"
 #include "TransformMultimer.hpp"
 #include "ZDOCK.hpp"
@@ -40,16 +41,18 @@ namespace zdock {
 class FilterConstraints {
 private:
   //! short hand for transformation
-  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+  typedef Eigen::Transform<float, 3, Eigen::Affine> Transform;
   //! short hand for coordinate matrix
-  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+  typedef Eigen::Matrix<float, 3, Eigen::Dynamic> Matrix;
 
   ZDOCK zdock_;                       //!< zdock output
-  const TransformLigand txl_;         //!< ligand tranfomation  (zdock)
-  const TransformMultimer txm_;       //!< structure tranfomation class (m-zdock)
+  const TransformLigandf txl_;        //!< ligand tranfomation  (zdock)
+  const TransformMultimerf txm_;      //!< structure tranfomation class (m-zdock)
   std::string confn_; //!< constraint file name
   std::string recfn_; //!< receptor filenames
   std::string ligfn_; //!< ligand filenames
+  const Selection selection_; //!< atoms eligible for constraints
+  const size_t nthreads_;     //!< number of threads
 
   //! constraints filtering for ZDOCK
   void filterZDOCKConstraints_();
@@ -61,7 +64,9 @@ public:
       const std::string &zdockoutput,      //!< zdock.out file
       const std::string &constraints,      //!< constraints file
       const std::string &receptorpdb = "", //!< or grab from zdock.out
-      const std::string &ligandpdb = ""    //!< or grab from zdock.out
+      const std::string &ligandpdb = "",   //!< or grab from zdock.out
+      const std::string &selection = "all", //!< atoms eligible for constraints
+      const size_t nthreads = 0 //!< number of threads (0: all hardware threads)
   );
 
   //! filter predictions based on constraints
@@ -25,10 +25,23 @@
  */
 
 #include "Pruning.hpp"
+#include "CellList.hpp"
+#include "FCC.hpp"
+#include "Metrics.hpp"
+#include "OnlinePruning.hpp"
 #include "PDB.hpp"
+#include "Parallel.hpp"
 #include "Utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <csignal>
 #include <cstdio>
+#include <fstream>
 #include <iomanip>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <sys/wait.h>
 #include <unistd.h>
 
 namespace zdock {
@@ -45,77 +58,92 @@ char spinner() {
 }
 
 Pruning::Pruning(const std::string &zdockoutput, const double cutoff,
-                 const std::string &structurefn, const bool getclusters)
+                 const std::string &structurefn, const bool getclusters,
+                 const std::string &selection, const size_t nthreads,
+                 const bool coordinates, const size_t budget,
+                 const Metric metric, const std::string &receptorfn,
+                 const size_t topk, const double idistance,
+                 const bool symmetric)
     : zdock_(zdockoutput), cutoff_(cutoff), txl_(zdockoutput),
-      txm_(zdockoutput), getclusters_(getclusters) {
+      txm_(zdockoutput), strucfn_(structurefn), recfn_(receptorfn),
+      getclusters_(getclusters), selection_(selection), nthreads_(nthreads),
+      coordinates_(coordinates), budget_(budget), metric_(metric),
+      topk_(topk), idistance_(idistance), symmetric_(symmetric),
+      strucsize_(0), nclusters_(0), npairs_(0), nskipped_(0) {}
 
-  // ligand file name
-  if (!zdock_.ismzdock()) {
-    // ZDOCK has "ligand"
-    if ("" == structurefn) {
-      strucfn_ = Utils::copath(zdockoutput, zdock_.ligand().filename);
-    } else {
-      strucfn_ = structurefn;
-    }
-  } else {
-    // M-ZDOCK has "structure"
-    if ("" == structurefn) {
-      strucfn_ = Utils::copath(zdockoutput, zdock_.structure().filename);
-    } else {
-      strucfn_ = structurefn;
+Pruning::Pruning(const Pruning &other, std::vector<Prediction> predictions,
+                 const size_t nthreads, const size_t budget)
+    : zdock_(other.zdock_), cutoff_(other.cutoff_), txl_(other.txl_),
+      txm_(other.txm_), strucfn_(other.strucfn_), recfn_(other.recfn_),
+      getclusters_(false), selection_(other.selection_), nthreads_(nthreads),
+      coordinates_(other.coordinates_), budget_(budget),
+      metric_(other.metric_), topk_(other.topk_), idistance_(other.idistance_),
+      symmetric_(other.symmetric_), strucsize_(0), nclusters_(0), npairs_(0),
+      nskipped_(0) {
+  zdock_.predictions().swap(predictions);
+}
+
+// centroid of every pose; resident poses from their coordinates, the
+// remainder from their transforms
+static std::vector<Eigen::Vector3d>
+centroids(const SoA<float> &poses, const TransformUtil::Transforms &tx,
+          const PDBf::Matrix &structure) {
+  std::vector<Eigen::Vector3d> c(poses.count() + tx.size());
+  for (size_t k = 0; k < poses.count(); ++k) {
+    double x = 0.0, y = 0.0, z = 0.0;
+    for (size_t a = 0; a < poses.natoms(); ++a) {
+      x += poses.x(k)[a];
+      y += poses.y(k)[a];
+      z += poses.z(k)[a];
     }
+    c[k] = Eigen::Vector3d(x, y, z) / static_cast<double>(poses.natoms());
+  }
+  const Eigen::Vector3d centroid =
+      structure.cast<double>().rowwise().mean();
+  for (size_t k = 0; k < tx.size(); ++k) {
+    c[poses.count() + k] = tx[k] * centroid;
   }
+  return c;
 }
 
-void Pruning::prune() {
-  const auto v = zdock_.predictions(); // our copy
-  const auto n = zdock_.npredictions();
-  auto &preds = zdock_.predictions();              // our ref
-  double min = std::numeric_limits<double>::max(); // big number
-  const bool ismzdock = zdock_.ismzdock();
-
-  // print some info on stderr
-  if (ismzdock) {
-    std::cerr << "Pruning for M-ZDOCK; cutoff: " << std::fixed
-              << std::setprecision(2) << cutoff_ << std::endl;
-  } else {
-    std::cerr << "Pruning for ZDOCK; cutoff: " << std::fixed
-              << std::setprecision(2) << cutoff_ << std::endl;
+// centroid of every embedded pose
+static std::vector<Eigen::Vector3d>
+centroids(const std::vector<PoseRMSD::Point> &poses) {
+  std::vector<Eigen::Vector3d> c(poses.size());
+  for (size_t k = 0; k < poses.size(); ++k) {
+    c[k] = Eigen::Vector3d(poses[k][0], poses[k][1], poses[k][2]);
   }
+  return c;
+}
 
-  // read pdb file (CA only!)
-  PDB pdb(strucfn_,
-          [](const auto &r) { return Utils::trim_copy(r.atom.name) == "CA"; });
-  const double strucsize = pdb.matrix().cols();
-
-  // pre-compute all poses
-  std::vector<Pruning::Matrix> poses0, poses1;
-  if (ismzdock) {
-    for (size_t i = 0; i < n; ++i) {
-      poses0.push_back(
-          txm_.txMultimer(pdb.matrix(), v[i], 0)); // "left side" of "receptor"
-      poses1.push_back(
-          txm_.txMultimer(pdb.matrix(), v[i], 2)); // "right side" of "receptor"
-    }
-  } else {
-    for (size_t i = 0; i < n; ++i) {
-      poses0.push_back(txl_.txLigand(pdb.matrix(), v[i]));
-    }
-  }
+template <typename C, typename B, typename S>
+void Pruning::cluster_(C &&candidates, B &&bounded, S &&similar) {
+  const auto v = zdock_.predictions(); // our copy
+  const auto n = zdock_.npredictions();
+  auto &preds = zdock_.predictions(); // our ref
 
   // find clusters
+  ThreadPool pool(nthreads_);
+  std::vector<std::vector<size_t>> members; // cluster members per chunk
+  std::vector<size_t> compared;             // pairs compared per chunk
+  std::vector<size_t> skipped;              // pairs rejected by bound
+  std::vector<size_t> cand;                 // unassigned candidates of center
+  size_t npairs = 0, nskipped = 0;
   zdock_.predictions().clear();
   std::vector<int> l(n, 0);
   int clusters = 0;
   int assigned = 0;
   char buf[100];
   const size_t interval = 100;
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("cluster", n);
   for (size_t i = 0; i < n; ++i) {
     if (!(i % interval)) {
       std::snprintf(buf, sizeof(buf),
                     "\r%c prediction: %ld, clusters: %d (%.2f%%)", spinner(), i,
                     clusters, 100.0 * assigned / n);
       std::cerr << buf << std::flush;
+      metrics.progress(i, npairs);
     }
     if (!l.at(i)) {
       l[i] = clusters + 1;
@@ -128,29 +156,47 @@ void Pruning::prune() {
       } else {
         preds.push_back(v[i]);
       }
-      for (size_t j = i + 1; j < n; ++j) {
-        if (!l.at(j)) {
-          double rmsd;
-          if (ismzdock) {
-            rmsd = std::min<double>(
-                std::sqrt((poses0.at(i) - poses0.at(j)).squaredNorm() /
-                          strucsize),
-                std::sqrt((poses0.at(i) - poses1.at(j)).squaredNorm() /
-                          strucsize));
-          } else {
-            rmsd = std::sqrt((poses0.at(i) - poses0.at(j)).squaredNorm() /
-                             strucsize);
+      // unassigned later predictions that may join this cluster, in
+      // prediction order
+      cand.clear();
+      candidates(i, l, cand);
+      // scan candidates in parallel; members are collected per chunk and
+      // appended in chunk order, matching the sequential scan
+      const size_t m = cand.size();
+      const size_t chunk = std::max<size_t>(256, m / (8 * pool.size()) + 1);
+      const size_t nchunks = (m + chunk - 1) / chunk;
+      members.resize(std::max(members.size(), nchunks));
+      compared.resize(std::max(compared.size(), nchunks));
+      skipped.resize(std::max(skipped.size(), nchunks));
+      pool.run(m, chunk, [&](size_t begin, size_t end) {
+        auto &hits = members[begin / chunk];
+        size_t ccompared = 0, cskipped = 0;
+        hits.clear();
+        for (size_t c = begin; c < end; ++c) {
+          const size_t j = cand[c];
+          ccompared++;
+          if (bounded(i, j)) {
+            cskipped++; // cannot be within cutoff
+            continue;
           }
-          min = std::min(min, rmsd); // just for stats
-          if (rmsd < cutoff_) {
+          if (similar(i, j)) {
             l[j] = clusters + 1;
-            assigned++;
-            if (getclusters_) {
-              // create prediction object w/ cluster number as score
-              auto tmppred = v[j];
-              tmppred.score = static_cast<double>(l[j]);
-              preds.push_back(tmppred);
-            }
+            hits.push_back(j);
+          }
+        }
+        compared[begin / chunk] = ccompared;
+        skipped[begin / chunk] = cskipped;
+      });
+      for (size_t c = 0; c < nchunks; ++c) {
+        npairs += compared[c];
+        nskipped += skipped[c];
+        for (const size_t j : members[c]) {
+          assigned++;
+          if (getclusters_) {
+            // create prediction object w/ cluster number as score
+            auto tmppred = v[j];
+            tmppred.score = static_cast<double>(l[j]);
+            preds.push_back(tmppred);
           }
         }
       }
@@ -160,11 +206,951 @@ void Pruning::prune() {
   std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld, clusters: %d (%.2f%%)",
                 '-', n, clusters, 100.0);
   std::cerr << buf << std::endl;
+  metrics.end(n, npairs);
+  std::snprintf(buf, sizeof(buf),
+                "candidate pairs: %ld, rejected by bound: %ld (%.2f%%)", npairs,
+                nskipped, npairs ? 100.0 * nskipped / npairs : 0.0);
+  std::cerr << buf << std::endl;
 
   // copy out results
   clusters_ = l;
-  strucsize_ = strucsize;
   nclusters_ = clusters;
+  npairs_ = npairs;
+  nskipped_ = nskipped;
+}
+
+template <typename C, typename B, typename D>
+void Pruning::neighbors_(C &&candidates, B &&bounded, D &&distance,
+                         NeighborGraph &graph) {
+  const auto n = zdock_.npredictions();
+
+  // like cluster_, but every prediction is a center and nothing is ever
+  // assigned
+  ThreadPool pool(nthreads_);
+  std::vector<std::vector<std::pair<size_t, double>>> pairs; // per chunk
+  std::vector<size_t> skipped;                // pairs rejected by bound
+  std::vector<size_t> cand;                   // later candidates of i
+  const std::vector<int> l(n, 0);
+  size_t npairs = 0, nskipped = 0;
+  char buf[100];
+  const size_t interval = 100;
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("neighbors", n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!(i % interval)) {
+      std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld, pairs: %ld",
+                    spinner(), i, graph.nedges());
+      std::cerr << buf << std::flush;
+      metrics.progress(i, npairs);
+    }
+    cand.clear();
+    candidates(i, l, cand);
+    const size_t m = cand.size();
+    const size_t chunk = std::max<size_t>(256, m / (8 * pool.size()) + 1);
+    const size_t nchunks = (m + chunk - 1) / chunk;
+    pairs.resize(std::max(pairs.size(), nchunks));
+    skipped.resize(std::max(skipped.size(), nchunks));
+    pool.run(m, chunk, [&](size_t begin, size_t end) {
+      auto &hits = pairs[begin / chunk];
+      size_t cskipped = 0;
+      hits.clear();
+      for (size_t c = begin; c < end; ++c) {
+        const size_t j = cand[c];
+        if (bounded(i, j)) {
+          cskipped++; // cannot be within cutoff
+          continue;
+        }
+        const double d = distance(i, j);
+        if (d < cutoff_) {
+          hits.emplace_back(j, d);
+        }
+      }
+      skipped[begin / chunk] = cskipped;
+    });
+    npairs += m;
+    for (size_t c = 0; c < nchunks; ++c) {
+      nskipped += skipped[c];
+      for (const auto &p : pairs[c]) {
+        graph.add(p.first, p.second);
+      }
+    }
+    graph.next();
+  }
+  std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld, pairs: %ld", '-', n,
+                graph.nedges());
+  std::cerr << buf << std::endl;
+  metrics.end(n, npairs);
+  std::snprintf(buf, sizeof(buf),
+                "candidate pairs: %ld, rejected by bound: %ld (%.2f%%)", npairs,
+                nskipped, npairs ? 100.0 * nskipped / npairs : 0.0);
+  std::cerr << buf << std::endl;
+  npairs_ = npairs;
+  nskipped_ = nskipped;
+}
+
+template <typename C, typename B, typename D>
+std::vector<std::vector<Prediction>>
+Pruning::clusterCutoffs_(C &&candidates, B &&bounded, D &&distance,
+                         const std::vector<double> &cutoffs) {
+  const auto &v = zdock_.predictions();
+  const auto n = zdock_.npredictions();
+  const size_t ncutoffs = cutoffs.size();
+
+  // one greedy assignment per cutoff, sharing distances; a prediction is a
+  // center at every cutoff at which it is still unassigned, and its
+  // candidates are the union of the candidates at those cutoffs
+  ThreadPool pool(nthreads_);
+  std::vector<std::vector<int>> l(ncutoffs, std::vector<int>(n, 0));
+  std::vector<int> clusters(ncutoffs, 0);
+  std::vector<std::vector<Prediction>> preds(ncutoffs);
+  std::vector<std::vector<std::vector<size_t>>> members; // chunk, cutoff
+  std::vector<size_t> compared;                          // pairs per chunk
+  std::vector<size_t> skipped; // pairs rejected by bound per chunk
+  std::vector<size_t> centers; // cutoffs at which i is a center
+  std::vector<size_t> cand;    // candidates of center i
+  size_t npairs = 0, nskipped = 0, assigned = 0;
+  auto assign = [&](const size_t k, const size_t j) {
+    if (getclusters_) {
+      // create prediction object w/ cluster number as score
+      auto tmppred = v[j];
+      tmppred.score = static_cast<double>(l[k][j]);
+      preds[k].push_back(tmppred);
+    }
+    assigned++;
+  };
+  char buf[100];
+  const size_t interval = 100;
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("cluster", n);
+  for (size_t i = 0; i < n; ++i) {
+    if (!(i % interval)) {
+      std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld (%.2f%%)",
+                    spinner(), i, 100.0 * assigned / (n * ncutoffs));
+      std::cerr << buf << std::flush;
+      metrics.progress(i, npairs);
+    }
+    centers.clear();
+    for (size_t k = 0; k < ncutoffs; ++k) {
+      if (!l[k][i]) {
+        centers.push_back(k);
+        l[k][i] = ++clusters[k];
+        if (!getclusters_) {
+          preds[k].push_back(v[i]);
+        }
+        assign(k, i);
+      }
+    }
+    if (centers.empty()) {
+      continue;
+    }
+    cand.clear();
+    for (const size_t k : centers) {
+      candidates(i, l[k], cand, k);
+    }
+    std::sort(cand.begin(), cand.end());
+    cand.erase(std::unique(cand.begin(), cand.end()), cand.end());
+    // scan candidates in parallel, as in cluster_
+    const size_t m = cand.size();
+    const size_t chunk = std::max<size_t>(256, m / (8 * pool.size()) + 1);
+    const size_t nchunks = (m + chunk - 1) / chunk;
+    members.resize(std::max(members.size(), nchunks));
+    compared.resize(std::max(compared.size(), nchunks));
+    skipped.resize(std::max(skipped.size(), nchunks));
+    pool.run(m, chunk, [&](size_t begin, size_t end) {
+      auto &hits = members[begin / chunk];
+      size_t ccompared = 0, cskipped = 0;
+      hits.resize(ncutoffs);
+      for (auto &h : hits) {
+        h.clear();
+      }
+      for (size_t c = begin; c < end; ++c) {
+        const size_t j = cand[c];
+        ccompared++;
+        if (std::all_of(centers.begin(), centers.end(), [&](const size_t k) {
+              return l[k][j] || bounded(i, j, k);
+            })) {
+          cskipped++; // cannot be within any cutoff
+          continue;
+        }
+        const double d = distance(i, j);
+        for (const size_t k : centers) {
+          if (!l[k][j] && d < cutoffs[k]) {
+            l[k][j] = clusters[k];
+            hits[k].push_back(j);
+          }
+        }
+      }
+      compared[begin / chunk] = ccompared;
+      skipped[begin / chunk] = cskipped;
+    });
+    for (const size_t k : centers) {
+      for (size_t c = 0; c < nchunks; ++c) {
+        for (const size_t j : members[c][k]) {
+          assign(k, j);
+        }
+      }
+    }
+    for (size_t c = 0; c < nchunks; ++c) {
+      npairs += compared[c];
+      nskipped += skipped[c];
+    }
+  }
+  std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld (%.2f%%)", '-', n,
+                100.0);
+  std::cerr << buf << std::endl;
+  metrics.end(n, npairs);
+  for (size_t k = 0; k < ncutoffs; ++k) {
+    std::snprintf(buf, sizeof(buf), "cutoff: %.2f, clusters: %d", cutoffs[k],
+                  clusters[k]);
+    std::cerr << buf << std::endl;
+  }
+  std::snprintf(buf, sizeof(buf),
+                "candidate pairs: %ld, rejected by bound: %ld (%.2f%%)", npairs,
+                nskipped, npairs ? 100.0 * nskipped / npairs : 0.0);
+  std::cerr << buf << std::endl;
+  npairs_ = npairs;
+  nskipped_ = nskipped;
+  return preds;
+}
+
+uint64_t Pruning::graphkey_(const PDBf::Matrix &atoms) const {
+  // everything distances depend on, the structure by its atom count and
+  // selected coordinates
+  std::ostringstream context;
+  context << static_cast<int>(metric_) << ' ' << selection_.expression()
+          << ' ' << coordinates_;
+  if (Metric::IRMSD == metric_) {
+    context << ' ' << topk_ << ' ' << idistance_;
+  }
+  if (symmetric_) {
+    context << " symmetric";
+  }
+  context << ' ' << atoms.cols() << ' ';
+  context.write(reinterpret_cast<const char *>(atoms.data()),
+                atoms.size() * sizeof(float));
+  return NeighborGraph::key(zdock_.predictions(), context.str());
+}
+
+NeighborGraph Pruning::neighbors() {
+  std::cerr << "Neighbor graph for "
+            << (zdock_.ismzdock() ? "M-ZDOCK" : "ZDOCK") << " by "
+            << (Metric::IRMSD == metric_ ? "interface RMSD" : "RMSD")
+            << "; cutoff: " << std::fixed << std::setprecision(2) << cutoff_
+            << std::endl;
+  if (Metric::FCC == metric_) {
+    throw PruningException("Neighbor graphs support RMSD metrics only");
+  }
+  const PDBf::Matrix atoms = rmsdAtoms_();
+  NeighborGraph graph(zdock_.npredictions(), cutoff_, graphkey_(atoms));
+  withRMSD_(atoms, {cutoff_},
+            [&](auto &candidates, auto &bounded, auto &rmsd) {
+              neighbors_(candidates, bounded, rmsd, graph);
+            });
+  return graph;
+}
+
+void Pruning::prune(const NeighborGraph &graph) {
+  std::cerr << "Pruning for " << (zdock_.ismzdock() ? "M-ZDOCK" : "ZDOCK")
+            << " from neighbor graph (" << graph.nedges()
+            << " pairs); cutoff: " << std::fixed << std::setprecision(2)
+            << cutoff_ << std::endl;
+  if (graph.size() != zdock_.npredictions() ||
+      graph.key() != graphkey_(rmsdAtoms_())) {
+    throw PruningException("Neighbor graph does not match predictions, "
+                           "metric, selection or structure");
+  }
+  if (cutoff_ > graph.cutoff()) {
+    throw PruningException("Cutoff exceeds neighbor graph cutoff");
+  }
+
+  // neighbors within the cutoff are exactly the cluster members
+  cluster_(
+      [&](const size_t i, const std::vector<int> &l,
+          std::vector<size_t> &cand) {
+        const uint32_t *j = graph.neighbors(i);
+        const double *d = graph.distances(i);
+        for (size_t k = 0; k < graph.degree(i); ++k) {
+          if (!l[j[k]] && d[k] < cutoff_) {
+            cand.push_back(j[k]);
+          }
+        }
+      },
+      [](const size_t, const size_t) { return false; },
+      [](const size_t, const size_t) { return true; });
+}
+
+void Pruning::prune() {
+  const bool ismzdock = zdock_.ismzdock();
+
+  // print some info on stderr
+  const char *name[] = {"RMSD", "FCC", "interface RMSD"};
+  std::cerr << "Pruning for " << (ismzdock ? "M-ZDOCK" : "ZDOCK") << " by "
+            << name[static_cast<int>(metric_)] << "; cutoff: " << std::fixed
+            << std::setprecision(2) << cutoff_ << std::endl;
+
+  if (Metric::FCC == metric_) {
+    pruneFCC_();
+  } else {
+    pruneRMSD_(rmsdAtoms_());
+  }
+}
+
+std::vector<ZDOCK> Pruning::prune(const std::vector<double> &cutoffs) {
+  const bool ismzdock = zdock_.ismzdock();
+  std::cerr << "Pruning for " << (ismzdock ? "M-ZDOCK" : "ZDOCK") << " by "
+            << (Metric::IRMSD == metric_ ? "interface RMSD" : "RMSD")
+            << "; cutoffs:" << std::fixed << std::setprecision(2);
+  for (const double c : cutoffs) {
+    std::cerr << ' ' << c;
+  }
+  std::cerr << std::endl;
+  if (Metric::FCC == metric_) {
+    throw PruningException("Multiple cutoffs support RMSD metrics only");
+  }
+  if (cutoffs.empty() ||
+      *std::max_element(cutoffs.begin(), cutoffs.end()) > cutoff_) {
+    throw PruningException("Cutoffs must not exceed the pruning cutoff");
+  }
+
+  std::vector<std::vector<Prediction>> preds;
+  withRMSD_(rmsdAtoms_(), cutoffs,
+            [&](auto &candidates, auto &bounded, auto &rmsd) {
+              preds = clusterCutoffs_(candidates, bounded, rmsd, cutoffs);
+            });
+  std::vector<ZDOCK> ret(cutoffs.size(), zdock_);
+  for (size_t k = 0; k < cutoffs.size(); ++k) {
+    ret[k].predictions().swap(preds[k]);
+  }
+  return ret;
+}
+
+// write all n bytes to a file descriptor
+static bool writeAll(const int fd, const void *buf, const size_t n) {
+  const char *p = static_cast<const char *>(buf);
+  for (size_t done = 0; done < n;) {
+    const ssize_t w = write(fd, p + done, n - done);
+    if (w <= 0) {
+      return false;
+    }
+    done += w;
+  }
+  return true;
+}
+
+// read exactly n bytes from a file descriptor
+static bool readAll(const int fd, void *buf, const size_t n) {
+  char *p = static_cast<char *>(buf);
+  for (size_t done = 0; done < n;) {
+    const ssize_t r = read(fd, p + done, n - done);
+    if (r <= 0) {
+      return false;
+    }
+    done += r;
+  }
+  return true;
+}
+
+void Pruning::pruneSharded(const size_t requested) {
+  const auto v = zdock_.predictions(); // our copy
+  const size_t n = v.size();
+  // at least one prediction per shard
+  const size_t nshards = std::max<size_t>(1, std::min(requested, n));
+  const size_t size = std::max<size_t>(1, (n + nshards - 1) / nshards);
+
+  // print some info on stderr
+  const char *name[] = {"RMSD", "FCC", "interface RMSD"};
+  std::cerr << "Pruning for " << (zdock_.ismzdock() ? "M-ZDOCK" : "ZDOCK")
+            << " by " << name[static_cast<int>(metric_)] << " in " << nshards
+            << " shards; cutoff: " << std::fixed << std::setprecision(2)
+            << cutoff_ << std::endl;
+  if (nshards > Parallel::nthreads(nthreads_)) {
+    std::cerr << "Warning: more shards than threads (" << nshards << " > "
+              << Parallel::nthreads(nthreads_)
+              << "); shards will compete for cores" << std::endl;
+  }
+
+  // atoms are selected once, before forking, so that all shards share them
+  // (for interface RMSD, the interface of the overall top predictions)
+  PDBf::Matrix atoms;
+  if (Metric::FCC != metric_) {
+    atoms = rmsdAtoms_();
+  }
+  auto run = [&atoms](Pruning &p) {
+    if (Metric::FCC == p.metric_) {
+      p.pruneFCC_();
+    } else {
+      p.pruneRMSD_(atoms);
+    }
+  };
+
+  // prune shards in child processes, which send back their counts and
+  // cluster assignments through a pipe
+  const size_t nthreads =
+      std::max<size_t>(1, Parallel::nthreads(nthreads_) / nshards);
+  std::vector<std::pair<pid_t, int>> children; // pid, read end of pipe
+  Metrics &metrics = Metrics::instance();
+  // on failure to start a shard, stop and reap those already started
+  auto stop = [&children](const std::string &msg) {
+    for (const auto &c : children) {
+      close(c.second);
+      kill(c.first, SIGKILL);
+      waitpid(c.first, nullptr, 0);
+    }
+    throw PruningException(msg);
+  };
+  std::cout << std::flush;
+  std::cerr << std::flush;
+  for (size_t begin = 0; begin < n; begin += size) {
+    const size_t end = std::min(n, begin + size);
+    int fd[2];
+    if (pipe(fd)) {
+      stop("Unable to create pipe");
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+      close(fd[0]);
+      close(fd[1]);
+      stop("Unable to create process");
+    }
+    if (!pid) {
+      // child: no progress output, results to the pipe
+      close(fd[0]);
+      std::cerr.setstate(std::ios::failbit);
+      metrics.close();
+      int ret = 1;
+      try {
+        Pruning p(*this, std::vector<Prediction>(v.begin() + begin,
+                                                 v.begin() + end),
+                  nthreads, budget_ / nshards);
+        run(p);
+        const size_t counts[2] = {p.npairs_, p.nskipped_};
+        if (writeAll(fd[1], counts, sizeof(counts)) &&
+            writeAll(fd[1], p.clusters_.data(),
+                     p.clusters_.size() * sizeof(int))) {
+          ret = 0;
+        }
+      } catch (const std::exception &e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+      } catch (...) {
+        std::fprintf(stderr, "Error: unknown exception in shard\n");
+      }
+      // never unwind into the parent's frames
+      close(fd[1]);
+      _exit(ret);
+    }
+    close(fd[1]);
+    children.emplace_back(pid, fd[0]);
+  }
+
+  // collect shard assignments, in order; a shard cluster's representative
+  // is its first member
+  std::vector<int> shardl(n, 0); // cluster within shard
+  std::vector<size_t> reps;      // representatives, in score order
+  std::vector<size_t> rep(n, 0); // representative of each prediction
+  std::vector<Prediction> repv;  // representative predictions
+  size_t npairs = 0, nskipped = 0;
+  bool failed = false;
+  metrics.stage("shards", children.size());
+  for (size_t s = 0; s < children.size(); ++s) {
+    const size_t begin = s * size, end = std::min(n, begin + size);
+    size_t counts[2] = {0, 0};
+    failed |= !readAll(children[s].second, counts, sizeof(counts)) ||
+              !readAll(children[s].second, shardl.data() + begin,
+                       (end - begin) * sizeof(int));
+    close(children[s].second);
+    int status = 0;
+    failed |= waitpid(children[s].first, &status, 0) < 0 ||
+              !WIFEXITED(status) || WEXITSTATUS(status);
+    npairs += counts[0];
+    nskipped += counts[1];
+    if (!failed) {
+      std::vector<size_t> first; // representative of each shard cluster
+      for (size_t j = begin; j < end; ++j) {
+        const size_t c = shardl[j];
+        if (c > first.size()) {
+          first.push_back(j);
+          reps.push_back(j);
+          repv.push_back(v[j]);
+        }
+        rep[j] = first.at(c - 1);
+      }
+    }
+    metrics.progress(s + 1, npairs);
+  }
+  metrics.end(children.size(), npairs);
+  if (failed) {
+    throw PruningException("Pruning of a shard failed");
+  }
+  std::cerr << "Shard representatives: " << reps.size() << " of " << n
+            << std::endl;
+
+  // prune representatives together, in score order
+  Pruning merged(*this, repv, nthreads_, budget_);
+  run(merged);
+  std::vector<int> repl(n, 0); // cluster of each representative
+  for (size_t r = 0; r < reps.size(); ++r) {
+    repl[reps[r]] = merged.clusters_[r];
+  }
+
+  // every prediction joins its representative's cluster; the first member
+  // of each cluster is a representative, and its center
+  std::vector<int> l(n);
+  for (size_t j = 0; j < n; ++j) {
+    l[j] = repl[rep[j]];
+  }
+  auto &preds = zdock_.predictions();
+  if (getclusters_) {
+    // all predictions w/ cluster number as score, grouped by cluster
+    std::vector<std::vector<size_t>> members(merged.nclusters_);
+    for (size_t j = 0; j < n; ++j) {
+      members[l[j] - 1].push_back(j);
+    }
+    preds.clear();
+    for (const auto &m : members) {
+      for (const size_t j : m) {
+        auto tmppred = v[j];
+        tmppred.score = static_cast<double>(l[j]);
+        preds.push_back(tmppred);
+      }
+    }
+  } else {
+    preds = merged.zdock_.predictions();
+  }
+
+  // copy out results
+  clusters_ = l;
+  nclusters_ = merged.nclusters_;
+  npairs_ = npairs + merged.npairs_;
+  nskipped_ = nskipped + merged.nskipped_;
+  strucsize_ = merged.strucsize_;
+}
+
+PDBf::Matrix Pruning::rmsdAtoms_() const {
+  if (Metric::IRMSD == metric_) {
+    return interface_();
+  }
+  // read pdb file (CA only, unless otherwise selected)
+  const PDBf pdb(structurefn_(), selection_);
+  if (!pdb.matrix().cols()) {
+    throw PruningException("No atoms selected by '" + selection_.expression() +
+                           "'");
+  }
+  return pdb.matrix();
+}
+
+std::string Pruning::structurefn_() const {
+  if ("" == strucfn_) {
+    // ZDOCK has "ligand", M-ZDOCK has "structure"
+    return Utils::copath(zdock_.filename(), zdock_.ismzdock()
+                                                ? zdock_.structure().filename
+                                                : zdock_.ligand().filename);
+  }
+  return strucfn_;
+}
+
+std::string Pruning::receptorfn_() const {
+  if ("" == recfn_) {
+    return Utils::copath(zdock_.filename(), zdock_.receptor().filename);
+  }
+  return recfn_;
+}
+
+PDBf::Matrix Pruning::interface_() const {
+  const auto &v = zdock_.predictions();
+  const size_t k = std::min(topk_, v.size());
+  const bool ismzdock = zdock_.ismzdock();
+
+  // heavy atom contacts in the top predictions (M-ZDOCK: between adjacent
+  // mers, so residues on either side count)
+  const Selection heavy("not hydrogen");
+  const PDB lig(structurefn_(), heavy);
+  const PDB rec = ismzdock ? lig : PDB(receptorfn_(), heavy);
+  const FCC fcc(rec, lig, idistance_);
+  const size_t nlig = lig.residues().size();
+  std::set<std::tuple<char, int, char>> residues; // chain, number, icode
+  auto add = [&residues](const ResidueRange &r) {
+    residues.insert(std::make_tuple(r.chain, r.seqNum, r.insertCode));
+  };
+  for (size_t i = 0; i < k; ++i) {
+    Eigen::Affine3d tx;
+    if (ismzdock) {
+      tx = txm_.transform(v[i], 0).inverse(Eigen::Isometry) *
+           txm_.transform(v[i], 1);
+    } else {
+      tx = txl_.transform(v[i]);
+    }
+    for (const uint32_t c : fcc.contacts(tx)) {
+      add(lig.residues()[c % nlig]);
+      if (ismzdock) {
+        add(rec.residues()[c / nlig]);
+      }
+    }
+  }
+
+  // selected atoms of interface residues
+  const PDBf pdb(structurefn_(), selection_);
+  std::vector<Eigen::Index> cols;
+  size_t nres = 0;
+  for (const auto &r : pdb.residues()) {
+    if (residues.count(std::make_tuple(r.chain, r.seqNum, r.insertCode))) {
+      nres++;
+      for (size_t a = r.begin; a < r.end; ++a) {
+        cols.push_back(a);
+      }
+    }
+  }
+  if (cols.empty()) {
+    throw PruningException("No interface atoms selected by '" +
+                           selection_.expression() + "'");
+  }
+  std::cerr << "Interface: " << nres << " of " << pdb.residues().size()
+            << " residues within " << idistance_ << " A in top " << k
+            << " predictions" << std::endl;
+  PDBf::Matrix m(3, cols.size());
+  for (size_t c = 0; c < cols.size(); ++c) {
+    m.col(c) = pdb.matrix().col(cols[c]);
+  }
+  return m;
+}
+
+void Pruning::pruneRMSD_(const PDBf::Matrix &atoms) {
+  withRMSD_(atoms, {cutoff_},
+            [this](auto &candidates, auto &bounded, auto &rmsd) {
+              cluster_(candidates, bounded,
+                       [&](const size_t i, const size_t j) {
+                         return rmsd(i, j) < cutoff_;
+                       });
+            });
+}
+
+template <typename F>
+void Pruning::withRMSD_(const PDBf::Matrix &atoms,
+                        const std::vector<double> &cutoffs, F &&f) {
+  const auto &v = zdock_.predictions();
+  const auto n = zdock_.npredictions();
+  const bool ismzdock = zdock_.ismzdock();
+  const double strucsize = atoms.cols();
+  // M-ZDOCK: pose j is either compared as its first and third mer, or, when
+  // symmetric, as the nearest of all its mers (rotations about the z axis
+  // by multiples of beta); then only the first mer is stored
+  const bool symmetric = ismzdock && symmetric_;
+  const bool twomers = ismzdock && !symmetric_;
+  const int nmers = symmetric ? txm_.symmetry() : 1;
+  const double beta = 2.0 * TransformUtil::PI / nmers;
+
+  // pre-compute all poses; by default each pose is reduced to its moment
+  // embedding, in which RMSD is a 12 dimensional distance, otherwise poses
+  // are transformed coordinates in a float arena (structure-of-arrays, one
+  // structure per pose). Poses that do not fit in the memory budget are not
+  // stored but recomputed from their transforms whenever they are compared.
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("poses", n);
+  std::vector<PoseRMSD::Point> emb0, emb1;
+  const size_t natoms = atoms.cols();
+  const SoA<float> structure(atoms);
+  SoA<float> poses0, poses1, center0;
+  TransformUtil::Transforms tx0, tx1; // transforms of non-resident poses
+  size_t resident = n;
+  std::vector<Eigen::Vector3d> cent0, cent1;
+  TransformUtil::Transforms unmers; // mer k back to mer 0 (symmetric)
+  if (coordinates_) {
+    const size_t posebytes =
+        (twomers ? 2 : 1) * 3 * structure.stride() * sizeof(float);
+    resident = std::min<size_t>(n, budget_ / posebytes);
+    poses0.resize(natoms, resident);
+    center0.resize(natoms, nmers);
+    if (symmetric) {
+      txm_.txMultimerBatch(structure, v, 0, resident, 0, poses0, nthreads_);
+      tx0 = txm_.transforms(v, resident, n, 0);
+      for (int k = 0; k < nmers; ++k) {
+        unmers.push_back(txm_.mer(k).inverse(Eigen::Isometry));
+      }
+    } else if (ismzdock) {
+      poses1.resize(natoms, resident);
+      txm_.txMultimerBatch(structure, v, 0, resident, 0, poses0,
+                           nthreads_); // "left side" of "receptor"
+      txm_.txMultimerBatch(structure, v, 0, resident, 2, poses1,
+                           nthreads_); // "right side" of "receptor"
+      tx0 = txm_.transforms(v, resident, n, 0);
+      tx1 = txm_.transforms(v, resident, n, 2);
+      cent1 = centroids(poses1, tx1, atoms);
+    } else {
+      txl_.txLigandBatch(structure, v, 0, resident, poses0, nthreads_);
+      tx0 = txl_.transforms(v, resident, n);
+    }
+    cent0 = centroids(poses0, tx0, atoms);
+    if (resident < n) {
+      std::cerr << "Memory budget holds " << resident << " of " << n
+                << " poses; recomputing the remainder" << std::endl;
+    }
+  } else {
+    // embed in blocks to bound the memory used by transforms
+    const PoseRMSD moments(atoms.cast<double>());
+    const size_t block = 65536;
+    emb0.reserve(n);
+    emb1.reserve(twomers ? n : 0);
+    for (size_t begin = 0; begin < n; begin += block) {
+      const size_t end = std::min(n, begin + block);
+      if (symmetric) {
+        const auto e0 = moments.embed(txm_.transforms(v, begin, end, 0));
+        emb0.insert(emb0.end(), e0.begin(), e0.end());
+      } else if (ismzdock) {
+        const auto e0 = moments.embed(txm_.transforms(v, begin, end, 0));
+        const auto e1 = moments.embed(txm_.transforms(v, begin, end, 2));
+        emb0.insert(emb0.end(), e0.begin(), e0.end());
+        emb1.insert(emb1.end(), e1.begin(), e1.end());
+      } else {
+        const auto e0 = moments.embed(txl_.transforms(v, begin, end));
+        emb0.insert(emb0.end(), e0.begin(), e0.end());
+      }
+      metrics.progress(end);
+    }
+    cent0 = centroids(emb0);
+    if (twomers) {
+      cent1 = centroids(emb1);
+    }
+  }
+  // RMSD between center pose i (in center0 for coordinates) and pose j
+  auto rmsd = [&](const size_t i, const size_t j) -> double {
+    if (coordinates_) {
+      const SoA<float> *p0 = &poses0, *p1 = &poses1;
+      size_t k0 = j, k1 = j;
+      if (j >= resident) {
+        // recompute pose in per-thread scratch
+        static thread_local SoA<float> scratch;
+        if (scratch.natoms() != natoms) {
+          scratch.resize(natoms, 2);
+        }
+        p0 = p1 = &scratch;
+        k0 = 0;
+        k1 = 1;
+        Simd::apply(tx0[j - resident], structure, 0, scratch, k0);
+        if (twomers) {
+          Simd::apply(tx1[j - resident], structure, 0, scratch, k1);
+        }
+      }
+      if (symmetric) {
+        // mer k of pose j against the center rotated back by mer k
+        double d = Simd::deviation2(center0, 0, *p0, k0);
+        for (int k = 1; k < nmers; ++k) {
+          d = std::min<double>(d, Simd::deviation2(center0, k, *p0, k0));
+        }
+        return std::sqrt(d / strucsize);
+      }
+      if (twomers) {
+        return std::min<double>(
+            std::sqrt(Simd::deviation2(center0, 0, *p0, k0) / strucsize),
+            std::sqrt(Simd::deviation2(center0, 0, *p1, k1) / strucsize));
+      }
+      return std::sqrt(Simd::deviation2(center0, 0, *p0, k0) / strucsize);
+    }
+    if (symmetric) {
+      return std::sqrt(PoseRMSD::rmsd2(emb0[i], emb0[j], nmers));
+    }
+    if (twomers) {
+      return std::sqrt(std::min(PoseRMSD::rmsd2(emb0[i], emb0[j]),
+                                PoseRMSD::rmsd2(emb0[i], emb1[j])));
+    }
+    return std::sqrt(PoseRMSD::rmsd2(emb0[i], emb0[j]));
+  };
+
+  // RMSD between two rigid poses of the same structure is never below the
+  // distance between their centroids, so pairs whose centroids are further
+  // apart than the cutoff can skip the full RMSD (the small margin keeps
+  // float round-off in the deviation from changing any assignment)
+  std::vector<double> bound(cutoffs.size()), bound2(cutoffs.size());
+  for (size_t g = 0; g < cutoffs.size(); ++g) {
+    bound[g] = cutoffs[g] * (1.0 + 1e-3);
+    bound2[g] = bound[g] * bound[g];
+  }
+  auto far = [&bound2](const Eigen::Vector3d &a, const Eigen::Vector3d &b,
+                       const size_t g) {
+    return (a - b).squaredNorm() > bound2[g];
+  };
+  // symmetric: centroids in cylindrical coordinates (r, z, 0) about the
+  // symmetry axis and their angles; the nearest mer centroid of pose j is
+  // the one whose angle is closest to that of pose i, and its distance is
+  // never below the (r, z) distance
+  std::vector<Eigen::Vector3d> cyl;
+  std::vector<double> phi;
+  if (symmetric) {
+    cyl.reserve(n);
+    phi.reserve(n);
+    for (const auto &c : cent0) {
+      cyl.emplace_back(std::hypot(c(0), c(1)), c(2), 0.0);
+      phi.push_back(std::atan2(c(1), c(0)));
+    }
+  }
+  auto farmers = [&](const size_t i, const size_t j, const size_t g) {
+    const double s = std::sin(0.5 * std::remainder(phi[i] - phi[j], beta));
+    return (cyl[i] - cyl[j]).squaredNorm() +
+               4.0 * cyl[i](0) * cyl[j](0) * s * s >
+           bound2[g];
+  };
+  const auto &binned = symmetric ? cyl : cent0;
+
+  // bin centroids in a cell list with the bound as cell size; only poses in
+  // the 27 cells around a cluster center can be within the cutoff (for
+  // M-ZDOCK both mer centroids are binned, or with all mers, the
+  // cylindrical coordinates). One cell list per cutoff.
+  std::vector<CellList> grids;
+  for (size_t g = 0; g < cutoffs.size(); ++g) {
+    grids.emplace_back(bound[g]);
+    for (size_t j = 0; j < n; ++j) {
+      grids[g].insert(binned[j], j);
+      if (twomers) {
+        grids[g].insert(cent1[j], j);
+      }
+    }
+  }
+
+  metrics.end(n);
+
+  // unassigned later predictions in neighboring cells (of the cell list of
+  // cutoff g)
+  auto candidates = [&](const size_t i, const std::vector<int> &l,
+                        std::vector<size_t> &cand, const size_t g = 0) {
+    grids[g].forEachNeighbor(binned[i], [&](const size_t j) {
+      if (j > i && !l[j]) {
+        cand.push_back(j);
+      }
+      return true;
+    });
+    std::sort(cand.begin(), cand.end());
+    cand.erase(std::unique(cand.begin(), cand.end()), cand.end());
+    // center pose
+    if (coordinates_) {
+      if (i < resident) {
+        const size_t len = 3 * poses0.stride();
+        std::copy(poses0.x(i), poses0.x(i) + len, center0.x());
+      } else {
+        Simd::apply(tx0[i - resident], structure, 0, center0, 0);
+      }
+      for (int k = 1; k < nmers; ++k) {
+        Simd::apply(unmers[k], center0, 0, center0, k);
+      }
+    }
+  };
+  auto bounded = [&](const size_t i, const size_t j, const size_t g = 0) {
+    if (symmetric) {
+      return farmers(i, j, g);
+    }
+    return far(cent0[i], cent0[j], g) &&
+           (!twomers || far(cent0[i], cent1[j], g));
+  };
+  f(candidates, bounded, rmsd);
+  strucsize_ = strucsize;
+}
+
+void Pruning::pruneFCC_() {
+  const auto &v = zdock_.predictions();
+  const auto n = zdock_.npredictions();
+
+  // receptor and ligand (M-ZDOCK: the structure is both), and transforms
+  // taking the ligand to the receptor frame (M-ZDOCK: mer 1 into the frame
+  // of mer 0)
+  const PDB lig(structurefn_(), selection_);
+  const PDB rec = zdock_.ismzdock() ? lig : PDB(receptorfn_(), selection_);
+  if (!lig.matrix().cols() || !rec.matrix().cols()) {
+    throw PruningException("No atoms selected by '" + selection_.expression() +
+                           "'");
+  }
+  TransformUtil::Transforms tx;
+  if (zdock_.ismzdock()) {
+    const auto tx0 = txm_.transforms(v, 0, n, 0);
+    tx = txm_.transforms(v, 0, n, 1);
+    for (size_t i = 0; i < n; ++i) {
+      tx[i] = tx0[i].inverse(Eigen::Isometry) * tx[i];
+    }
+  } else {
+    tx = txl_.transforms(v, 0, n);
+  }
+  const FCC fcc(rec, lig);
+  Metrics::instance().stage("contacts", n);
+  const FCC::Fingerprints fp = fcc.fingerprints(tx, nthreads_);
+  Metrics::instance().end(n);
+  TransformUtil::Transforms().swap(tx);
+
+  // all unassigned later predictions are candidates; the strict FCC can not
+  // exceed the ratio of the smaller to the larger contact count
+  cluster_(
+      [&](const size_t i, const std::vector<int> &l,
+          std::vector<size_t> &cand) {
+        for (size_t j = i + 1; j < n; ++j) {
+          if (!l[j]) {
+            cand.push_back(j);
+          }
+        }
+      },
+      [&](const size_t i, const size_t j) {
+        const double a = fp.count(i), b = fp.count(j);
+        return std::min(a, b) < cutoff_ * std::max(a, b);
+      },
+      [&](const size_t i, const size_t j) {
+        return fp.similarity(i, j) >= cutoff_;
+      });
+  strucsize_ = lig.matrix().cols();
+}
+
+size_t Pruning::stream(std::istream &in, std::ostream &out,
+                       const double cutoff, const std::string &structurefn,
+                       const bool getclusters, const std::string &selection) {
+  ZDOCK z(in); // header and first prediction
+  const bool ismzdock = z.ismzdock();
+  std::cerr << "Pruning " << (ismzdock ? "M-ZDOCK" : "ZDOCK")
+            << " stream by RMSD; cutoff: " << std::fixed
+            << std::setprecision(2) << cutoff << std::endl;
+
+  // structure (CA only, unless otherwise selected)
+  std::string strucfn = structurefn;
+  if ("" == strucfn) {
+    strucfn = Utils::copath(z.filename(), ismzdock ? z.structure().filename
+                                                   : z.ligand().filename);
+  }
+  // single precision coordinates, as in prune(), so moments are the same
+  const PDBf pdb(strucfn, Selection(selection));
+  if (!pdb.matrix().cols()) {
+    throw PruningException("No atoms selected by '" + selection + "'");
+  }
+  OnlinePruning online(z, pdb.matrix().cast<double>(), cutoff);
+
+  // header
+  std::vector<Prediction> preds;
+  preds.swap(z.predictions());
+  out << z << std::flush;
+
+  // predictions, as they arrive
+  char buf[100];
+  const size_t interval = 100;
+  Metrics &metrics = Metrics::instance();
+  metrics.stage("stream"); // total unknown
+  Prediction p;
+  for (bool more = !preds.empty(); more; more = z.next(in, p)) {
+    if (!preds.empty()) {
+      p = preds.back(); // first prediction, read with the header
+      preds.clear();
+    }
+    if (!(online.size() % interval)) {
+      std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld, clusters: %ld",
+                    spinner(), online.size(), online.nclusters());
+      std::cerr << buf << std::flush;
+      metrics.progress(online.size());
+    }
+    const auto a = online.add(p);
+    if (getclusters) {
+      // prediction w/ cluster number as score
+      p.score = static_cast<double>(a.cluster);
+      out << '\n' << p << std::flush;
+    } else if (a.representative) {
+      out << '\n' << p << std::flush;
+    }
+  }
+  out << std::endl;
+  std::snprintf(buf, sizeof(buf), "\r%c prediction: %ld, clusters: %ld", '-',
+                online.size(), online.nclusters());
+  std::cerr << buf << std::endl;
+  metrics.end(online.size());
+  return online.nclusters();
 }
 
 void usage(const std::string &cmd, const std::string &err = "") {
@@ -175,32 +1161,138 @@ void usage(const std::string &cmd, const std::string &err = "") {
   // print usage
   std::cerr
       << "usage: " << cmd << " [options] <zdock output>\n\n"
-      << "  -c <double>     cutoff RMSD (defaults to 16.00)\n"
+      << "  Use '-' as zdock output to prune predictions as they arrive on\n"
+      << "  standard input (moment based RMSD only; -C output is in input\n"
+      << "  order).\n\n"
+      << "  -m <metric>     similarity measure; rmsd (default), fcc, fraction\n"
+      << "                  of common residue contacts, or irmsd, RMSD over\n"
+      << "                  interface residues only\n"
+      << "  -c <double>     cutoff; maximum RMSD (defaults to 16.00) or\n"
+      << "                  minimum FCC (defaults to 0.75); a comma separated\n"
+      << "                  list of RMSD cutoffs prunes at each in one pass\n"
+      << "  -p <string>     output filename prefix for a list of cutoffs,\n"
+      << "                  each written to <prefix><cutoff> (defaults to\n"
+      << "                  \"pruning.\")\n"
       << "  -C              return all prediction, but with score replaced by\n"
       << "                  cluster number.\n"
       << "  -l <filename>   structure PDB filename; defaults to ligand in "
          "ZDOCK\n"
+      << "  -r <filename>   receptor PDB filename, for FCC and interface RMSD;\n"
+      << "                  defaults to receptor in ZDOCK\n"
+      << "  -k <integer>    top predictions defining the interface (defaults\n"
+      << "                  to 10)\n"
+      << "  -d <double>     interface distance (defaults to 10.00)\n"
+      << "  -s <selection>  atoms used (defaults to \"name CA\" for (interface)\n"
+      << "                  RMSD and \"not hydrogen\" for FCC)\n"
+      << "  -j <integer>    number of threads (defaults to all cores)\n"
+      << "  -S <integer>    number of shards; predictions are split by rank,\n"
+      << "                  each shard is pruned in its own process, and the\n"
+      << "                  shard representatives are pruned together\n"
+      << "                  (defaults to 1, no sharding; at most one per\n"
+      << "                  prediction)\n"
+      << "  -y              M-ZDOCK: compare poses over all symmetry-equivalent\n"
+      << "                  mers (defaults to the first and third mer)\n"
+      << "  -x              compute RMSD from transformed coordinates instead\n"
+      << "                  of structure moments\n"
+      << "  -M <integer>    memory budget for transformed coordinates in MB\n"
+      << "                  (defaults to 2048); poses beyond the budget are\n"
+      << "                  recomputed as needed\n"
+      << "  -g <filename>   save all pairs within the cutoff to a neighbor\n"
+      << "                  graph file (RMSD and interface RMSD)\n"
+      << "  -G <filename>   prune from a neighbor graph file saved with -g,\n"
+      << "                  for any cutoff up to the one it was saved with\n"
+      << "  -P <fd|file>    write progress metrics as JSON lines to a file\n"
+      << "                  descriptor (number) or file\n"
       << std::endl;
 }
 
 } // namespace zdock
 
 int main(int argc, char *argv[]) {
-  std::string zdockfn, ligfn;
-  double cutoff = 16.00;
+  std::string zdockfn, ligfn, recfn, selection, graphout, graphin;
+  std::string prefix = "pruning.";
+  std::string metricsfn; // progress metrics target
+  double cutoff = -1.0; // metric default
+  std::vector<std::string> cutoffs; // several cutoffs, as given
+  zdock::Pruning::Metric metric = zdock::Pruning::Metric::RMSD;
   bool getclusters = false;
+  int nthreads = 0;
+  int nshards = 1;
+  bool coordinates = false;
+  bool symmetric = false;
+  long budget = 2048;
   int c;
-  while ((c = getopt(argc, argv, "hc:l:C")) != -1) {
+  int topk = 10;
+  double idistance = 10.0;
+  while ((c = getopt(argc, argv, "hm:c:p:l:r:k:d:s:j:S:CxyM:g:G:P:")) != -1) {
     switch (c) {
-    case 'c':
-      cutoff = std::stod(optarg);
+    case 'm':
+      if (std::string("rmsd") == optarg) {
+        metric = zdock::Pruning::Metric::RMSD;
+      } else if (std::string("fcc") == optarg) {
+        metric = zdock::Pruning::Metric::FCC;
+      } else if (std::string("irmsd") == optarg) {
+        metric = zdock::Pruning::Metric::IRMSD;
+      } else {
+        zdock::usage(argv[0], "Unknown metric '" + std::string(optarg) + "'.");
+        return 1;
+      }
+      break;
+    case 'c': {
+      // one cutoff, or a comma separated list
+      std::istringstream list(optarg);
+      std::string c;
+      cutoffs.clear();
+      while (std::getline(list, c, ',')) {
+        cutoffs.push_back(c);
+      }
+      break;
+    }
+    case 'p':
+      prefix = optarg;
       break;
     case 'l':
       ligfn = optarg;
       break;
+    case 'r':
+      recfn = optarg;
+      break;
+    case 'k':
+      topk = std::stoi(optarg);
+      break;
+    case 'd':
+      idistance = std::stod(optarg);
+      break;
     case 'C':
       getclusters = true;
       break;
+    case 's':
+      selection = optarg;
+      break;
+    case 'j':
+      nthreads = std::stoi(optarg);
+      break;
+    case 'S':
+      nshards = std::stoi(optarg);
+      break;
+    case 'x':
+      coordinates = true;
+      break;
+    case 'y':
+      symmetric = true;
+      break;
+    case 'M':
+      budget = std::stol(optarg);
+      break;
+    case 'g':
+      graphout = optarg;
+      break;
+    case 'G':
+      graphin = optarg;
+      break;
+    case 'P':
+      metricsfn = optarg;
+      break;
     case 'h': // usage
       zdock::usage(argv[0]);
       return 0;
@@ -217,10 +1309,112 @@ int main(int argc, char *argv[]) {
     zdock::usage(argv[0], "No ZDOCK output file specified.");
     return 1;
   }
+  if (nthreads < 0) {
+    zdock::usage(argv[0], "Invalid number of threads.");
+    return 1;
+  }
+  if (budget < 0) {
+    zdock::usage(argv[0], "Invalid memory budget.");
+    return 1;
+  }
+  if (nshards < 1) {
+    zdock::usage(argv[0], "Invalid number of shards.");
+    return 1;
+  }
+  if (topk < 1) {
+    zdock::usage(argv[0], "Invalid number of top predictions.");
+    return 1;
+  }
+  if (idistance <= 0.0) {
+    zdock::usage(argv[0], "Invalid interface distance.");
+    return 1;
+  }
+  const bool fcc = zdock::Pruning::Metric::FCC == metric;
+  if ("" != graphout && "" != graphin) {
+    zdock::usage(argv[0], "Only one of -g and -G can be given.");
+    return 1;
+  }
+  if (fcc && ("" != graphout || "" != graphin)) {
+    zdock::usage(argv[0], "Neighbor graphs support RMSD metrics only.");
+    return 1;
+  }
+  for (const auto &c : cutoffs) {
+    cutoff = std::max(cutoff, std::stod(c)); // largest
+  }
+  if (nshards > 1 &&
+      (cutoffs.size() > 1 || "" != graphout || "" != graphin)) {
+    zdock::usage(argv[0], "Shards support a single cutoff without neighbor "
+                          "graphs only.");
+    return 1;
+  }
+  if (cutoffs.size() > 1 && (fcc || "" != graphout || "" != graphin)) {
+    zdock::usage(argv[0], "Multiple cutoffs support RMSD metrics without "
+                          "neighbor graphs only.");
+    return 1;
+  }
+  if (cutoff < 0.0) {
+    cutoff = fcc ? 0.75 : 16.00;
+  }
+  if ("" == selection) {
+    selection = fcc ? "not hydrogen" : "name CA";
+  }
   try {
     const auto t1 = zdock::Utils::tic();
-    zdock::Pruning p(zdockfn, cutoff, ligfn, getclusters);
-    p.prune();
+    if ("" != metricsfn) {
+      zdock::Metrics::instance().open(metricsfn);
+    }
+    if ("-" == zdockfn) {
+      if (zdock::Pruning::Metric::RMSD != metric || coordinates ||
+          symmetric || cutoffs.size() > 1 || nshards > 1) {
+        zdock::usage(argv[0], "Streaming supports moment based RMSD with a "
+                              "single cutoff only.");
+        return 1;
+      }
+      if ("" != graphout || "" != graphin) {
+        zdock::usage(argv[0], "Streaming does not support neighbor graphs.");
+        return 1;
+      }
+      zdock::Pruning::stream(std::cin, std::cout, cutoff, ligfn, getclusters,
+                             selection);
+      std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec"
+                << std::endl;
+      return 0;
+    }
+    zdock::Pruning p(zdockfn, cutoff, ligfn, getclusters, selection,
+                     nthreads, coordinates,
+                     static_cast<size_t>(budget) << 20, metric, recfn, topk,
+                     idistance, symmetric);
+    if (cutoffs.size() > 1) {
+      // one output file per cutoff
+      std::vector<double> values;
+      for (const auto &c : cutoffs) {
+        values.push_back(std::stod(c));
+      }
+      const auto pruned = p.prune(values);
+      for (size_t k = 0; k < cutoffs.size(); ++k) {
+        const std::string ofn = prefix + cutoffs[k];
+        std::ofstream f(ofn);
+        if (!f.is_open()) {
+          throw zdock::PruningException("Error opening output file '" + ofn +
+                                        "'");
+        }
+        f << pruned[k] << std::endl;
+      }
+      std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec"
+                << std::endl;
+      return 0;
+    }
+    if ("" != graphout) {
+      const zdock::NeighborGraph graph = p.neighbors();
+      graph.save(graphout);
+      p.prune(graph);
+    } else if ("" != graphin) {
+      p.prune(zdock::NeighborGraph::load(graphin));
+    } else if (nshards > 1) {
+      p.pruneSharded(nshards);
+    } else {
+      p.prune();
+    }
     std::cout << p.zdock() << std::endl;
     std::cerr << "duration: " << zdock::Utils::toc(t1) << " sec" << std::endl;
   } catch (const zdock::Exception &e) {
@@ -27,11 +27,18 @@
 #pragma once
 
 #include "Exception.hpp"
+#include "NeighborGraph.hpp"
+#include "PDB.hpp"
+#include "PoseRMSD.hpp"
+#include "Selection.hpp"
 #include "TransformLigand.hpp"
 #include "TransformMultimer.hpp"
 #include "ZDOCK.hpp"
 #include <Eigen/Dense>
+#include <istream>
+#include <ostream>
 #include <string>
+#include <vector>
 
 namespace zdock {
 
@@ -39,21 +46,84 @@ namespace zdock {
  * @brief Perform RMSD based pruning on (M-)ZDOCK output
  */
 class Pruning {
+public:
+  /**
+   * @brief Similarity measure used for clustering
+   */
+  enum class Metric {
+    RMSD, //!< RMSD over the selected atoms; cutoff is a maximum
+    FCC,  //!< fraction of common residue contacts; cutoff is a minimum
+    IRMSD //!< RMSD over the selected atoms of interface residues
+  };
+
 private:
-  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
-  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+  typedef Eigen::Transform<float, 3, Eigen::Affine> Transform;
+  typedef Eigen::Matrix<float, 3, Eigen::Dynamic> Matrix;
 
   ZDOCK zdock_;                 // zdock output
   const double cutoff_;         // cutoff
-  const TransformLigand txl_;   // ligand tranfomation class
-  const TransformMultimer txm_; // multimertranfomation class
-  std::string strucfn_;         // receptor and ligand filenames
+  const TransformLigandf txl_;   // ligand tranfomation class
+  const TransformMultimerf txm_; // multimertranfomation class
+  const std::string strucfn_;   // ligand (M-ZDOCK: structure) filename
+  const std::string recfn_;     // receptor filename (FCC)
   const bool getclusters_;      // return all w/ cluster number in score
+  const Selection selection_;   // atoms used for RMSD
+  const size_t nthreads_;       // number of threads
+  const bool coordinates_;      // RMSD from coordinates, not moments
+  const size_t budget_;         // bytes for transformed coordinates
+  const Metric metric_;         // similarity measure
+  const size_t topk_;           // predictions defining the interface
+  const double idistance_;      // interface distance
+  const bool symmetric_;        // M-ZDOCK: compare all symmetric mers
 
   // results
   std::vector<int> clusters_; // cluster assignments
   size_t strucsize_;          // structure size
   int nclusters_;             // number of clusters
+  size_t npairs_;             // candidate pairs
+  size_t nskipped_;           // pairs rejected by a bound
+
+  // same parameters as other, for a subset of its predictions
+  Pruning(const Pruning &other, std::vector<Prediction> predictions,
+          const size_t nthreads, const size_t budget);
+
+  // greedy clustering in prediction order; candidates(i, assignments,
+  // out) lists candidate members of center i, bounded(i, j) rejects pairs
+  // cheaply, similar(i, j) decides membership
+  template <typename C, typename B, typename S>
+  void cluster_(C &&candidates, B &&bounded, S &&similar);
+  // all pairs within the cutoff; candidates and bounded as for cluster_,
+  // distance(i, j) gives the distance of a pair
+  template <typename C, typename B, typename D>
+  void neighbors_(C &&candidates, B &&bounded, D &&distance,
+                  NeighborGraph &graph);
+  // greedy clustering at several cutoffs at once, each pair distance
+  // computed once; candidates and bounded as for withRMSD_, distance(i, j)
+  // gives the distance of a pair
+  template <typename C, typename B, typename D>
+  std::vector<std::vector<Prediction>>
+  clusterCutoffs_(C &&candidates, B &&bounded, D &&distance,
+                  const std::vector<double> &cutoffs);
+  // key of predictions, metric and structure atoms for neighbor graphs
+  uint64_t graphkey_(const PDBf::Matrix &atoms) const;
+  // ligand (M-ZDOCK: structure) file name
+  std::string structurefn_() const;
+  // receptor file name
+  std::string receptorfn_() const;
+  // selected atoms of ligand (M-ZDOCK: structure) interface residues
+  PDBf::Matrix interface_() const;
+  // atoms defining the RMSD (selection, or its interface residues)
+  PDBf::Matrix rmsdAtoms_() const;
+  // set up RMSD between poses over atoms and call f(candidates, bounded,
+  // rmsd), with arguments as for cluster_ and neighbors_; candidates and
+  // bounded take an optional index into cutoffs (defaults to the first)
+  template <typename F>
+  void withRMSD_(const PDBf::Matrix &atoms, const std::vector<double> &cutoffs,
+                 F &&f);
+  // prune by RMSD over atoms
+  void pruneRMSD_(const PDBf::Matrix &atoms);
+  // prune by fraction of common contacts
+  void pruneFCC_();
 
 public:
   /**
@@ -63,17 +133,110 @@ public:
    * @param cutoff RMSD cutoff
    * @param structurefn Structure PDB file name
    * @param getclusters Toggle return for full (M-)ZDOCK output with cluster numbers for scores
+   * @param selection Atom selection used for RMSD (defaults to CA atoms)
+   * @param nthreads Number of threads (0 for all hardware threads)
+   * @param coordinates Compute RMSD from transformed coordinates instead of
+   * the constant time moment form (see PoseRMSD)
+   * @param budget Memory budget in bytes for transformed coordinates; poses
+   * beyond the budget are recomputed whenever they are compared
+   * @param metric Similarity measure
+   * @param receptorfn Receptor PDB file name, used by FCC and interface
+   * RMSD (defaults to receptor in zdock.out)
+   * @param topk Number of top predictions defining the interface for
+   * interface RMSD
+   * @param idistance Distance from the receptor (M-ZDOCK: the adjacent mer)
+   * within which residues are part of the interface
+   * @param symmetric M-ZDOCK: compare poses over all symmetry-equivalent
+   * mers instead of the first and third only
    */
   Pruning(
       const std::string &zdockoutput, const double cutoff,
       const std::string &structurefn = "", // or grab from zdock.out
-      const bool getclusters = false // return all w/ cluster number in score
+      const bool getclusters = false, // return all w/ cluster number in score
+      const std::string &selection = "name CA", // atoms used for RMSD
+      const size_t nthreads = 0,                 // 0: all hardware threads
+      const bool coordinates = false,            // RMSD from coordinates
+      const size_t budget = 2048UL << 20,        // coordinate memory budget
+      const Metric metric = Metric::RMSD,        // similarity measure
+      const std::string &receptorfn = "",        // or grab from zdock.out
+      const size_t topk = 10,                    // interface predictions
+      const double idistance = 10.0,             // interface distance
+      const bool symmetric = false               // all symmetric mers
   );
 
   /**
    * @brief Actually perform pruning
    */
   void prune();
+  /**
+   * @brief Compute all pairs of predictions within the cutoff
+   *
+   * The graph reproduces prune() for any cutoff up to this one (see
+   * prune(const NeighborGraph &)). RMSD and interface RMSD only.
+   *
+   * @return graph of pairs within the cutoff
+   */
+  NeighborGraph neighbors();
+  /**
+   * @brief Perform pruning from precomputed pairs
+   *
+   * @param graph pairs within a cutoff at least this one, computed by
+   * neighbors() for the same predictions, metric, selection and structure
+   */
+  void prune(const NeighborGraph &graph);
+  /**
+   * @brief Perform pruning at several cutoffs in one pass
+   *
+   * Every RMSD computed is used for all cutoffs at once, so this costs
+   * about as much as pruning at the smallest cutoff alone. Results equal
+   * those of prune() at each cutoff. RMSD and interface RMSD only.
+   *
+   * @param cutoffs cutoffs, none larger than the one given to the
+   * constructor
+   * @return (M-)ZDOCK output pruned at each cutoff, in the order given
+   */
+  std::vector<ZDOCK> prune(const std::vector<double> &cutoffs);
+  /**
+   * @brief Perform pruning in separate processes
+   *
+   * Predictions are split by score rank into consecutive shards, which are
+   * pruned independently in forked processes. The shard representatives
+   * are then pruned together, in global score order, and every prediction
+   * joins the cluster of its shard representative. The result depends only
+   * on the number of shards. It approximates prune(): a prediction is only
+   * compared with cluster centers of its own shard, so some assignments
+   * can differ from a single pass.
+   *
+   * @param nshards number of shards (processes), at most one per
+   * prediction; threads and memory budget are divided among them
+   */
+  void pruneSharded(const size_t nshards);
+  /**
+   * @brief Prune (M-)ZDOCK output arriving on a stream
+   *
+   * Predictions are clustered as they are read (see OnlinePruning), by
+   * RMSD, and written out as soon as their assignment is final. RMSDs are
+   * computed as by prune() with structure moments, from the same single
+   * precision structure, and bounds only skip pairs beyond the cutoff, so
+   * cluster assignments equal those of prune() for the same input. With
+   * getclusters, predictions are written in input order rather than
+   * grouped by cluster.
+   *
+   * @param in input stream with (M-)ZDOCK output, in score order
+   * @param out output stream
+   * @param cutoff RMSD cutoff
+   * @param structurefn Structure PDB file name (defaults to the one in the
+   * header, relative to the working directory)
+   * @param getclusters Toggle output of all predictions with cluster numbers
+   * for scores
+   * @param selection Atom selection used for RMSD
+   * @return number of clusters
+   */
+  static size_t stream(std::istream &in, std::ostream &out,
+                       const double cutoff,
+                       const std::string &structurefn = "",
+                       const bool getclusters = false,
+                       const std::string &selection = "name CA");
   /**
    * @brief Get cluster assignments
    *
@@ -86,6 +249,19 @@ public:
    * @return number of clusters found
    */
   int nclusters() const { return nclusters_; }
+  /**
+   * @brief Get number of candidate pose pairs
+   *
+   * @return number of candidate pairs
+   */
+  size_t npairs() const { return npairs_; }
+  /**
+   * @brief Get number of pairs rejected by a bound (centroid distance for
+   * RMSD, contact counts for FCC)
+   *
+   * @return number of pairs for which no full comparison was made
+   */
+  size_t nskipped() const { return nskipped_; }
   /**
    * @brief Get ZDOCK output with cluster numbers for scores
    *
@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Uniform grid (cell list) over a set of 3D points
+ *
+ * Points are binned into cubic cells of a fixed size. Any two points closer
+ * than the cell size are guaranteed to be in the same or in adjacent cells,
+ * so neighbor searches only have to visit 27 cells.
+ */
+class CellList {
+public:
+  //! point type
+  typedef Eigen::Vector3d Coord;
+
+private:
+  double size_;                                           //!< cell size
+  std::unordered_map<uint64_t, std::vector<size_t>> cells_; //!< cell members
+
+  //! cell index along one axis
+  inline int64_t cell_(const double x) const {
+    return static_cast<int64_t>(std::floor(x / size_));
+  }
+
+  //! pack three cell indices (21 bits each) into one key
+  static inline uint64_t key_(const int64_t i, const int64_t j,
+                              const int64_t k) {
+    const uint64_t m = (1UL << 21) - 1;
+    return ((static_cast<uint64_t>(i) & m) << 42) |
+           ((static_cast<uint64_t>(j) & m) << 21) |
+           (static_cast<uint64_t>(k) & m);
+  }
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param size cell size (typically the interaction cutoff)
+   */
+  CellList(const double size) : size_(size) {}
+
+  //! get cell size
+  double size() const { return size_; }
+
+  //! get number of occupied cells
+  size_t ncells() const { return cells_.size(); }
+
+  /**
+   * @brief Add a point to the grid
+   *
+   * @param p coordinate
+   * @param id identifier passed back by forEachNeighbor()
+   */
+  template <typename V> void insert(const V &p, const size_t id) {
+    cells_[key_(cell_(p(0)), cell_(p(1)), cell_(p(2)))].push_back(id);
+  }
+
+  /**
+   * @brief Remove all points
+   */
+  void clear() { cells_.clear(); }
+
+  /**
+   * @brief Visit all points in the cell of p and its 26 neighbors
+   *
+   * Identifiers are visited in insertion order per cell. Visiting stops
+   * early when fn returns false.
+   *
+   * @param p query coordinate
+   * @param fn callback, bool(size_t id)
+   * @return false if visiting was stopped early
+   */
+  template <typename V, typename F>
+  bool forEachNeighbor(const V &p, F &&fn) const {
+    const int64_t ci = cell_(p(0)), cj = cell_(p(1)), ck = cell_(p(2));
+    for (int64_t i = ci - 1; i <= ci + 1; ++i) {
+      for (int64_t j = cj - 1; j <= cj + 1; ++j) {
+        for (int64_t k = ck - 1; k <= ck + 1; ++k) {
+          const auto c = cells_.find(key_(i, j, k));
+          if (cells_.end() != c) {
+            for (const size_t id : c->second) {
+              if (!fn(id)) {
+                return false;
+              }
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace zdock
@@ -52,6 +52,21 @@ public:
   ConstraintException(const std::string &msg) : Exception(msg) {}
 };
 
+class FCCException : public Exception {
+public:
+  FCCException(const std::string &msg) : Exception(msg) {}
+};
+
+class MetricsException : public Exception {
+public:
+  MetricsException(const std::string &msg) : Exception(msg) {}
+};
+
+class NeighborGraphException : public Exception {
+public:
+  NeighborGraphException(const std::string &msg) : Exception(msg) {}
+};
+
 class PathException : public Exception {
 public:
   PathException(const std::string &msg) : Exception(msg) {}
@@ -63,6 +78,21 @@ public:
       : Exception("Error opening PDB file '" + fn + "'") {}
 };
 
+class PoseIndexException : public Exception {
+public:
+  PoseIndexException(const std::string &msg) : Exception(msg) {}
+};
+
+class PoseRMSDException : public Exception {
+public:
+  PoseRMSDException(const std::string &msg) : Exception(msg) {}
+};
+
+class SelectionException : public Exception {
+public:
+  SelectionException(const std::string &msg) : Exception(msg) {}
+};
+
 class ZDOCKInvalidFormat : public Exception {
 public:
   ZDOCKInvalidFormat(const std::string &fn, const std::string &msg = "")
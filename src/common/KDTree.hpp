@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Static k-d tree for nearest neighbor queries in D dimensions
+ *
+ * The tree is stored implicitly: each range of points is split at its
+ * median along the dimension of largest spread, and the median point is
+ * kept in the middle of the range.
+ */
+template <int D> class KDTree {
+public:
+  //! point type
+  typedef std::array<double, D> Point;
+  //! query result; squared distance and point id
+  typedef std::pair<double, size_t> Neighbor;
+
+private:
+  static const size_t LEAF = 8; //!< maximum points per leaf
+
+  std::vector<Point> points_;  //!< points in tree order
+  std::vector<size_t> ids_;    //!< original point ids, in tree order
+  std::vector<uint8_t> dims_;  //!< split dimension at each median
+
+  //! squared distance between two points
+  static inline double distance2_(const Point &a, const Point &b) {
+    double d = 0.0;
+    for (int i = 0; i < D; ++i) {
+      d += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return d;
+  }
+
+  //! recursively split range [b, e) of ids
+  void build_(std::vector<size_t> &ids, const std::vector<Point> &points,
+              const size_t b, const size_t e) {
+    if (e - b <= LEAF) {
+      return;
+    }
+    // dimension of largest spread
+    Point lo = points[ids[b]], hi = points[ids[b]];
+    for (size_t i = b + 1; i < e; ++i) {
+      for (int k = 0; k < D; ++k) {
+        lo[k] = std::min(lo[k], points[ids[i]][k]);
+        hi[k] = std::max(hi[k], points[ids[i]][k]);
+      }
+    }
+    int d = 0;
+    for (int k = 1; k < D; ++k) {
+      if (hi[k] - lo[k] > hi[d] - lo[d]) {
+        d = k;
+      }
+    }
+    const size_t m = b + (e - b) / 2;
+    std::nth_element(ids.begin() + b, ids.begin() + m, ids.begin() + e,
+                     [&](size_t x, size_t y) {
+                       return points[x][d] < points[y][d];
+                     });
+    dims_[m] = static_cast<uint8_t>(d);
+    build_(ids, points, b, m);
+    build_(ids, points, m + 1, e);
+  }
+
+  //! k nearest neighbor search in range [b, e)
+  template <typename Heap>
+  void search_(const Point &q, const size_t k, const size_t b, const size_t e,
+               Heap &heap) const {
+    const auto consider = [&](size_t i) {
+      const double d = distance2_(q, points_[i]);
+      if (heap.size() < k) {
+        heap.emplace(d, ids_[i]);
+      } else if (d < heap.top().first) {
+        heap.pop();
+        heap.emplace(d, ids_[i]);
+      }
+    };
+    if (e - b <= LEAF) {
+      for (size_t i = b; i < e; ++i) {
+        consider(i);
+      }
+      return;
+    }
+    const size_t m = b + (e - b) / 2;
+    const double diff = q[dims_[m]] - points_[m][dims_[m]];
+    consider(m);
+    if (diff < 0) {
+      search_(q, k, b, m, heap);
+      if (heap.size() < k || diff * diff < heap.top().first) {
+        search_(q, k, m + 1, e, heap);
+      }
+    } else {
+      search_(q, k, m + 1, e, heap);
+      if (heap.size() < k || diff * diff < heap.top().first) {
+        search_(q, k, b, m, heap);
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param points points; ids are positions in this vector
+   */
+  KDTree(const std::vector<Point> &points = std::vector<Point>())
+      : dims_(points.size(), 0) {
+    std::vector<size_t> ids(points.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      ids[i] = i;
+    }
+    build_(ids, points, 0, ids.size());
+    // store points in tree order
+    points_.reserve(points.size());
+    for (const auto i : ids) {
+      points_.push_back(points[i]);
+    }
+    ids_ = ids;
+  }
+
+  //! number of points
+  size_t size() const { return points_.size(); }
+
+  /**
+   * @brief k nearest neighbors of a point
+   *
+   * @param q query point
+   * @param k number of neighbors
+   * @return neighbors, nearest first
+   */
+  std::vector<Neighbor> nearest(const Point &q, const size_t k) const {
+    std::priority_queue<Neighbor> heap; // max-heap; worst on top
+    if (k > 0) {
+      search_(q, k, 0, points_.size(), heap);
+    }
+    std::vector<Neighbor> ret(heap.size());
+    for (size_t i = ret.size(); i > 0; --i) {
+      ret[i - 1] = heap.top();
+      heap.pop();
+    }
+    return ret;
+  }
+};
+
+} // namespace zdock
@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "Exception.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace zdock {
+
+/**
+ * @brief Machine readable progress of long running tools
+ *
+ * Records are written as JSON lines to a file descriptor or file, e.g.
+ *
+ *     {"event": "progress", "stage": "cluster", "time": 12.04,
+ *      "items": 51200, "total": 200000, "rate": 4253.1, "eta": 35.0,
+ *      "pairs": 1834417, "peak_rss_kb": 181240}
+ *
+ * (on one line). A stage emits a "start" record, "progress" records at
+ * most once per interval, and an "end" record. The channel is disabled
+ * until opened; progress() then returns after a single test.
+ */
+class Metrics {
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  int fd_;                   // output, -1 when disabled
+  bool owned_;               // fd_ opened (and closed) by us
+  double interval_;          // seconds between progress records
+  Clock::time_point start_;  // channel opened
+  Clock::time_point stage0_; // stage started
+  Clock::time_point last_;   // last record
+  std::string stage_;        // stage name
+  size_t total_;             // items in stage, 0 if unknown
+
+  static double seconds_(const Clock::time_point &a,
+                         const Clock::time_point &b) {
+    return std::chrono::duration<double>(b - a).count();
+  }
+
+  // write one record
+  void emit_(const char *event, const size_t items, const size_t pairs) {
+    const auto now = Clock::now();
+    const double elapsed = seconds_(stage0_, now);
+    const double rate = elapsed > 0.0 ? items / elapsed : 0.0;
+    char eta[32] = "null";
+    if (total_ && rate > 0.0) {
+      std::snprintf(eta, sizeof(eta), "%.1f",
+                    items < total_ ? (total_ - items) / rate : 0.0);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    char buf[512];
+    const int len = std::snprintf(
+        buf, sizeof(buf),
+        "{\"event\": \"%s\", \"stage\": \"%s\", \"time\": %.2f, "
+        "\"items\": %zu, \"total\": %zu, \"rate\": %.1f, \"eta\": %s, "
+        "\"pairs\": %zu, \"peak_rss_kb\": %ld}\n",
+        event, stage_.c_str(), seconds_(start_, now), items, total_, rate,
+        eta, pairs, static_cast<long>(usage.ru_maxrss));
+    if (len > 0 &&
+        write(fd_, buf, std::min<size_t>(len, sizeof(buf) - 1)) < 0) {
+      fd_ = -1; // reader went away; stop reporting
+    }
+    last_ = now;
+  }
+
+public:
+  Metrics()
+      : fd_(-1), owned_(false), interval_(1.0), start_(Clock::now()),
+        stage0_(start_), last_(start_), total_(0) {}
+  Metrics(const Metrics &) = delete;
+  Metrics &operator=(const Metrics &) = delete;
+  ~Metrics() { close(); }
+
+  /**
+   * @brief Process wide channel, used by all tools
+   */
+  static Metrics &instance() {
+    static Metrics m;
+    return m;
+  }
+
+  /**
+   * @brief Start writing records
+   *
+   * @param target file descriptor number (e.g. "3"), or file name
+   * @param interval minimum number of seconds between progress records
+   */
+  void open(const std::string &target, const double interval = 1.0) {
+    close();
+    const bool isfd =
+        !target.empty() && target.find_first_not_of("0123456789") ==
+                               std::string::npos;
+    if (isfd) {
+      fd_ = std::stoi(target);
+      if (fcntl(fd_, F_GETFD) < 0) {
+        fd_ = -1;
+        throw MetricsException("Invalid file descriptor " + target);
+      }
+    } else {
+      fd_ = ::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd_ < 0) {
+        throw MetricsException("Error opening '" + target + "'");
+      }
+    }
+    owned_ = !isfd;
+    interval_ = interval;
+    start_ = stage0_ = last_ = Clock::now();
+  }
+
+  /**
+   * @brief Stop writing records
+   */
+  void close() {
+    if (owned_ && fd_ >= 0) {
+      ::close(fd_);
+    }
+    fd_ = -1;
+    owned_ = false;
+  }
+
+  //! records are written
+  bool enabled() const { return fd_ >= 0; }
+
+  /**
+   * @brief Begin a stage
+   *
+   * @param name stage name
+   * @param total number of items in the stage (0 if unknown)
+   */
+  void stage(const std::string &name, const size_t total = 0) {
+    if (fd_ < 0) {
+      return;
+    }
+    stage_ = name;
+    total_ = total;
+    stage0_ = Clock::now();
+    emit_("start", 0, 0);
+  }
+
+  /**
+   * @brief Report progress in the current stage (rate limited)
+   *
+   * @param items items processed so far
+   * @param pairs pairs evaluated so far
+   */
+  void progress(const size_t items, const size_t pairs = 0) {
+    if (fd_ < 0) {
+      return;
+    }
+    if (seconds_(last_, Clock::now()) >= interval_) {
+      emit_("progress", items, pairs);
+    }
+  }
+
+  /**
+   * @brief End the current stage
+   *
+   * @param items items processed
+   * @param pairs pairs evaluated
+   */
+  void end(const size_t items, const size_t pairs = 0) {
+    if (fd_ < 0) {
+      return;
+    }
+    emit_("end", items, pairs);
+  }
+};
+
+} // namespace zdock
@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Minimal helpers for data parallel loops
+ */
+class Parallel {
+public:
+  /**
+   * @brief Resolve a requested number of threads
+   *
+   * @param n requested number of threads; 0 for all hardware threads
+   * @return number of threads to use (at least 1)
+   */
+  static size_t nthreads(const size_t n = 0) {
+    if (n > 0) {
+      return n;
+    }
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * @brief Split [0, n) into contiguous chunks, one per thread
+   *
+   * The calling thread processes the first chunk. Exceptions thrown by fn
+   * are rethrown in the calling thread once all threads have finished.
+   *
+   * @param n number of items
+   * @param nthreads number of threads (0 for all hardware threads)
+   * @param fn callback, void(size_t begin, size_t end)
+   */
+  template <typename F>
+  static void forRange(const size_t n, const size_t nthreads, F &&fn) {
+    const size_t nt =
+        std::min(Parallel::nthreads(nthreads), std::max<size_t>(n, 1));
+    if (nt <= 1) {
+      fn(static_cast<size_t>(0), n);
+      return;
+    }
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(nt);
+    const size_t chunk = (n + nt - 1) / nt;
+    for (size_t t = 1; t < nt; ++t) {
+      threads.emplace_back([&, t]() {
+        try {
+          fn(std::min(n, t * chunk), std::min(n, (t + 1) * chunk));
+        } catch (...) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    try {
+      fn(static_cast<size_t>(0), std::min(n, chunk));
+    } catch (...) {
+      errors[0] = std::current_exception();
+    }
+    for (auto &x : threads) {
+      x.join();
+    }
+    for (const auto &e : errors) {
+      if (e) {
+        std::rethrow_exception(e);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Persistent worker threads for repeated parallel loops
+ *
+ * Unlike Parallel::forRange, threads are started once, which keeps the cost
+ * of many short loops (e.g. one per greedy clustering step) low. Work is
+ * handed out in chunks from a shared counter, so uneven chunks balance out.
+ */
+class ThreadPool {
+private:
+  std::vector<std::thread> workers_;
+  std::mutex lock_;
+  std::condition_variable start_, done_;
+  std::function<void(size_t, size_t)> task_; // current loop body
+  size_t n_, chunk_;                          // current loop range
+  std::atomic<size_t> next_;                  // next chunk start
+  size_t active_;                             // workers still running
+  uint64_t generation_;                       // loop counter
+  bool stop_;
+  std::exception_ptr error_;
+
+  // process chunks until the range is exhausted
+  void work_() {
+    try {
+      for (size_t b = next_.fetch_add(chunk_); b < n_;
+           b = next_.fetch_add(chunk_)) {
+        task_(b, std::min(n_, b + chunk_));
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> l(lock_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      next_ = n_; // stop handing out work
+    }
+  }
+
+  void worker_() {
+    uint64_t generation = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> l(lock_);
+        start_.wait(l, [&]() { return stop_ || generation != generation_; });
+        if (stop_) {
+          return;
+        }
+        generation = generation_;
+      }
+      work_();
+      {
+        std::lock_guard<std::mutex> l(lock_);
+        if (0 == --active_) {
+          done_.notify_one();
+        }
+      }
+    }
+  }
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param nthreads number of threads, including the calling thread (0 for
+   * all hardware threads)
+   */
+  explicit ThreadPool(const size_t nthreads = 0)
+      : n_(0), chunk_(1), next_(0), active_(0), generation_(0), stop_(false) {
+    for (size_t i = 1; i < Parallel::nthreads(nthreads); ++i) {
+      workers_.emplace_back(&ThreadPool::worker_, this);
+    }
+  }
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> l(lock_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto &x : workers_) {
+      x.join();
+    }
+  }
+
+  //! number of threads, including the calling thread
+  size_t size() const { return workers_.size() + 1; }
+
+  /**
+   * @brief Run fn over [0, n) in chunks; blocks until done
+   *
+   * The calling thread takes part. Exceptions thrown by fn are rethrown
+   * here.
+   *
+   * @param n number of items
+   * @param chunk chunk size
+   * @param fn callback, void(size_t begin, size_t end)
+   */
+  template <typename F> void run(const size_t n, const size_t chunk, F &&fn) {
+    const size_t c = std::max<size_t>(chunk, 1);
+    if (workers_.empty() || n <= c) {
+      for (size_t b = 0; b < n; b += c) {
+        fn(b, std::min(n, b + c));
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> l(lock_);
+      task_ = std::forward<F>(fn);
+      n_ = n;
+      chunk_ = c;
+      next_ = 0;
+      active_ = workers_.size();
+      error_ = nullptr;
+      ++generation_;
+    }
+    start_.notify_all();
+    work_();
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> l(lock_);
+      done_.wait(l, [&]() { return 0 == active_; });
+      task_ = nullptr;
+      error = error_;
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+} // namespace zdock
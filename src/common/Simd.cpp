@@ -0,0 +1,277 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Simd.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ZDOCK_SIMD_X86 1
+#define ZDOCK_TARGET(t) __attribute__((target(t)))
+#else
+#define ZDOCK_SIMD_X86 0
+#endif
+
+#define ZDOCK_INLINE inline __attribute__((always_inline))
+
+namespace zdock {
+
+namespace {
+
+/*
+ * Kernel bodies, written on vectors of B bytes using GCC vector extensions.
+ * They are forced inline into the per target entry points below, so the
+ * same source compiles to SSE, AVX2 or AVX-512 instructions.
+ */
+
+template <typename V, typename T> ZDOCK_INLINE void load_(V &v, const T *p) {
+  std::memcpy(&v, p, sizeof(V));
+}
+
+template <typename V, typename T> ZDOCK_INLINE void store_(T *p, const V &v) {
+  std::memcpy(p, &v, sizeof(V));
+}
+
+template <typename T, size_t B>
+ZDOCK_INLINE void apply_(const T *m, const T *x, const T *y, const T *z,
+                         size_t n, T *ox, T *oy, T *oz) {
+  typedef T V __attribute__((vector_size(B)));
+  const size_t w = B / sizeof(T);
+  size_t i = 0;
+  for (; i + w <= n; i += w) {
+    V vx, vy, vz;
+    load_(vx, x + i);
+    load_(vy, y + i);
+    load_(vz, z + i);
+    const V rx = m[0] * vx + m[1] * vy + m[2] * vz + m[9];
+    const V ry = m[3] * vx + m[4] * vy + m[5] * vz + m[10];
+    const V rz = m[6] * vx + m[7] * vy + m[8] * vz + m[11];
+    store_(ox + i, rx);
+    store_(oy + i, ry);
+    store_(oz + i, rz);
+  }
+  for (; i < n; ++i) {
+    const T vx = x[i], vy = y[i], vz = z[i];
+    ox[i] = m[0] * vx + m[1] * vy + m[2] * vz + m[9];
+    oy[i] = m[3] * vx + m[4] * vy + m[5] * vz + m[10];
+    oz[i] = m[6] * vx + m[7] * vy + m[8] * vz + m[11];
+  }
+}
+
+template <typename T, size_t B>
+ZDOCK_INLINE void translate_(const T *t, const T *x, const T *y, const T *z,
+                             size_t n, T *ox, T *oy, T *oz) {
+  typedef T V __attribute__((vector_size(B)));
+  const size_t w = B / sizeof(T);
+  size_t i = 0;
+  for (; i + w <= n; i += w) {
+    V vx, vy, vz;
+    load_(vx, x + i);
+    load_(vy, y + i);
+    load_(vz, z + i);
+    const V rx = vx + t[0], ry = vy + t[1], rz = vz + t[2];
+    store_(ox + i, rx);
+    store_(oy + i, ry);
+    store_(oz + i, rz);
+  }
+  for (; i < n; ++i) {
+    ox[i] = x[i] + t[0];
+    oy[i] = y[i] + t[1];
+    oz[i] = z[i] + t[2];
+  }
+}
+
+template <typename T, size_t B>
+ZDOCK_INLINE void distance2_(const T *ax, const T *ay, const T *az,
+                             const T *bx, const T *by, const T *bz, size_t n,
+                             T *out) {
+  typedef T V __attribute__((vector_size(B)));
+  const size_t w = B / sizeof(T);
+  size_t i = 0;
+  for (; i + w <= n; i += w) {
+    V vax, vay, vaz, vbx, vby, vbz;
+    load_(vax, ax + i);
+    load_(vay, ay + i);
+    load_(vaz, az + i);
+    load_(vbx, bx + i);
+    load_(vby, by + i);
+    load_(vbz, bz + i);
+    const V dx = vax - vbx, dy = vay - vby, dz = vaz - vbz;
+    const V d = dx * dx + dy * dy + dz * dz;
+    store_(out + i, d);
+  }
+  for (; i < n; ++i) {
+    const T dx = ax[i] - bx[i], dy = ay[i] - by[i], dz = az[i] - bz[i];
+    out[i] = dx * dx + dy * dy + dz * dz;
+  }
+}
+
+template <typename T, size_t B>
+ZDOCK_INLINE T deviation2_(const T *ax, const T *ay, const T *az,
+                           const T *bx, const T *by, const T *bz, size_t n) {
+  typedef T V __attribute__((vector_size(B)));
+  const size_t w = B / sizeof(T);
+  V acc = {};
+  size_t i = 0;
+  for (; i + w <= n; i += w) {
+    V vax, vay, vaz, vbx, vby, vbz;
+    load_(vax, ax + i);
+    load_(vay, ay + i);
+    load_(vaz, az + i);
+    load_(vbx, bx + i);
+    load_(vby, by + i);
+    load_(vbz, bz + i);
+    const V dx = vax - vbx, dy = vay - vby, dz = vaz - vbz;
+    acc += dx * dx + dy * dy + dz * dz;
+  }
+  T sum = 0;
+  for (size_t k = 0; k < w; ++k) {
+    sum += acc[k];
+  }
+  for (; i < n; ++i) {
+    const T dx = ax[i] - bx[i], dy = ay[i] - by[i], dz = az[i] - bz[i];
+    sum += dx * dx + dy * dy + dz * dz;
+  }
+  return sum;
+}
+
+// per target entry points
+#define ZDOCK_KERNELS(SUFFIX, ATTR, BYTES)                                     \
+  template <typename T>                                                        \
+  ATTR void apply##SUFFIX(const T *m, const T *x, const T *y, const T *z,      \
+                          size_t n, T *ox, T *oy, T *oz) {                     \
+    apply_<T, BYTES>(m, x, y, z, n, ox, oy, oz);                               \
+  }                                                                            \
+  template <typename T>                                                        \
+  ATTR void translate##SUFFIX(const T *t, const T *x, const T *y, const T *z,  \
+                              size_t n, T *ox, T *oy, T *oz) {                 \
+    translate_<T, BYTES>(t, x, y, z, n, ox, oy, oz);                           \
+  }                                                                            \
+  template <typename T>                                                        \
+  ATTR void distance2##SUFFIX(const T *ax, const T *ay, const T *az,           \
+                              const T *bx, const T *by, const T *bz, size_t n, \
+                              T *out) {                                        \
+    distance2_<T, BYTES>(ax, ay, az, bx, by, bz, n, out);                      \
+  }                                                                            \
+  template <typename T>                                                        \
+  ATTR T deviation2##SUFFIX(const T *ax, const T *ay, const T *az,             \
+                            const T *bx, const T *by, const T *bz, size_t n) { \
+    return deviation2_<T, BYTES>(ax, ay, az, bx, by, bz, n);                   \
+  }
+
+ZDOCK_KERNELS(Generic, , 16)
+#if ZDOCK_SIMD_X86
+ZDOCK_KERNELS(Avx2, ZDOCK_TARGET("avx2,fma"), 32)
+ZDOCK_KERNELS(Avx512, ZDOCK_TARGET("avx512f"), 64)
+#endif
+
+#undef ZDOCK_KERNELS
+
+// best level supported by this CPU, unless overridden
+Simd::Level detect_() {
+  const char *env = std::getenv("ZDOCK_SIMD");
+  if (env) {
+    const std::string s(env);
+    if ("avx512" == s && Simd::supported(Simd::AVX512)) {
+      return Simd::AVX512;
+    } else if ("avx2" == s && Simd::supported(Simd::AVX2)) {
+      return Simd::AVX2;
+    } else if ("generic" == s) {
+      return Simd::GENERIC;
+    }
+  }
+  if (Simd::supported(Simd::AVX512)) {
+    return Simd::AVX512;
+  } else if (Simd::supported(Simd::AVX2)) {
+    return Simd::AVX2;
+  }
+  return Simd::GENERIC;
+}
+
+} // namespace
+
+Simd::Level Simd::level() {
+  static const Level l = detect_();
+  return l;
+}
+
+bool Simd::supported(const Level l) {
+#if ZDOCK_SIMD_X86
+  __builtin_cpu_init();
+  switch (l) {
+  case AVX512:
+    return __builtin_cpu_supports("avx512f");
+  case AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  default:
+    return true;
+  }
+#else
+  return GENERIC == l;
+#endif
+}
+
+const char *Simd::name(const Level l) {
+  switch (l) {
+  case AVX512:
+    return "avx512";
+  case AVX2:
+    return "avx2";
+  default:
+    return "generic";
+  }
+}
+
+template <typename T> const Simd::Kernels<T> &Simd::kernels(const Level l) {
+  static const Kernels<T> generic = {applyGeneric<T>, translateGeneric<T>,
+                                     distance2Generic<T>,
+                                     deviation2Generic<T>};
+#if ZDOCK_SIMD_X86
+  static const Kernels<T> avx2 = {applyAvx2<T>, translateAvx2<T>,
+                                  distance2Avx2<T>, deviation2Avx2<T>};
+  static const Kernels<T> avx512 = {applyAvx512<T>, translateAvx512<T>,
+                                    distance2Avx512<T>, deviation2Avx512<T>};
+  assert(supported(l));
+  switch (l) {
+  case AVX512:
+    return avx512;
+  case AVX2:
+    return avx2;
+  default:
+    return generic;
+  }
+#else
+  (void)l;
+  return generic;
+#endif
+}
+
+// explicit instantiations; double and single precision coordinates
+template const Simd::Kernels<double> &Simd::kernels(const Level);
+template const Simd::Kernels<float> &Simd::kernels(const Level);
+
+} // namespace zdock
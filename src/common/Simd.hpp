@@ -0,0 +1,258 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <Eigen/Dense>
+#include <cassert>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Structure-of-arrays coordinate buffer
+ *
+ * Holds count structures of natoms atoms each. Coordinates of structure k
+ * are stored as three separate arrays x, y and z, each padded to a multiple
+ * of 16 elements, so that kernels can vectorize across atoms.
+ */
+template <typename T> class SoA {
+public:
+  //! column-major coordinate matrix type
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Matrix;
+
+private:
+  size_t natoms_, count_, stride_;
+  std::vector<T, Eigen::aligned_allocator<T>> data_;
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param natoms number of atoms per structure
+   * @param count number of structures
+   */
+  SoA(const size_t natoms = 0, const size_t count = 1) {
+    resize(natoms, count);
+  }
+  /**
+   * @brief Constructor; single structure from coordinate matrix
+   *
+   * @param m 3xN coordinate matrix
+   */
+  SoA(const Matrix &m) : SoA(m.cols(), 1) { set(0, m); }
+
+  /**
+   * @brief Resize buffer (contents are zeroed)
+   *
+   * @param natoms number of atoms per structure
+   * @param count number of structures
+   */
+  void resize(const size_t natoms, const size_t count) {
+    natoms_ = natoms;
+    count_ = count;
+    stride_ = (natoms + 15) & ~static_cast<size_t>(15);
+    data_.assign(3 * stride_ * count, T(0));
+  }
+
+  //! x coordinates of structure k
+  T *x(const size_t k = 0) { return data_.data() + 3 * k * stride_; }
+  //! y coordinates of structure k
+  T *y(const size_t k = 0) { return x(k) + stride_; }
+  //! z coordinates of structure k
+  T *z(const size_t k = 0) { return x(k) + 2 * stride_; }
+  //! x coordinates of structure k
+  const T *x(const size_t k = 0) const {
+    return data_.data() + 3 * k * stride_;
+  }
+  //! y coordinates of structure k
+  const T *y(const size_t k = 0) const { return x(k) + stride_; }
+  //! z coordinates of structure k
+  const T *z(const size_t k = 0) const { return x(k) + 2 * stride_; }
+
+  //! number of atoms per structure
+  size_t natoms() const { return natoms_; }
+  //! number of structures
+  size_t count() const { return count_; }
+  //! padded array length
+  size_t stride() const { return stride_; }
+
+  /**
+   * @brief Copy coordinates into structure k
+   *
+   * @param k structure
+   * @param m 3xN coordinate matrix
+   */
+  void set(const size_t k, const Matrix &m) {
+    assert(k < count_ && static_cast<size_t>(m.cols()) == natoms_);
+    for (size_t i = 0; i < natoms_; ++i) {
+      x(k)[i] = m(0, i);
+      y(k)[i] = m(1, i);
+      z(k)[i] = m(2, i);
+    }
+  }
+  /**
+   * @brief Coordinates of structure k as a matrix
+   *
+   * @param k structure
+   * @return 3xN coordinate matrix
+   */
+  Matrix matrix(const size_t k = 0) const {
+    Matrix m(3, natoms_);
+    for (size_t i = 0; i < natoms_; ++i) {
+      m.col(i) << x(k)[i], y(k)[i], z(k)[i];
+    }
+    return m;
+  }
+};
+
+/**
+ * @brief SIMD kernels on SoA coordinates, selected at runtime
+ *
+ * Kernels are compiled for a generic target, AVX2 and AVX-512; the best
+ * one supported by the CPU is selected at first use. The selection can be
+ * overridden through the ZDOCK_SIMD environment variable (generic, avx2 or
+ * avx512).
+ */
+class Simd {
+public:
+  //! instruction set level
+  enum Level { GENERIC, AVX2, AVX512 };
+
+  //! kernel table for scalar type T
+  template <typename T> struct Kernels {
+    //! out = R * in + t; m holds R (row-major) followed by t
+    void (*apply)(const T *m, const T *x, const T *y, const T *z, size_t n,
+                  T *ox, T *oy, T *oz);
+    //! out = in + t
+    void (*translate)(const T *t, const T *x, const T *y, const T *z,
+                      size_t n, T *ox, T *oy, T *oz);
+    //! per atom squared distance between a and b
+    void (*distance2)(const T *ax, const T *ay, const T *az, const T *bx,
+                      const T *by, const T *bz, size_t n, T *out);
+    //! sum of squared deviations between a and b
+    T (*deviation2)(const T *ax, const T *ay, const T *az, const T *bx,
+                    const T *by, const T *bz, size_t n);
+  };
+
+  /**
+   * @brief Selected instruction set level
+   *
+   * @return best level supported, or as set through ZDOCK_SIMD
+   */
+  static Level level();
+  /**
+   * @brief Check whether the CPU supports a level
+   *
+   * @param l instruction set level
+   * @return true if supported
+   */
+  static bool supported(const Level l);
+  /**
+   * @brief Name of a level
+   *
+   * @param l instruction set level
+   * @return level name
+   */
+  static const char *name(const Level l);
+  /**
+   * @brief Get kernel table
+   *
+   * @param l instruction set level (must be supported)
+   * @return kernels
+   */
+  template <typename T> static const Kernels<T> &kernels(const Level l);
+  /**
+   * @brief Get kernel table for the selected level
+   *
+   * @return kernels
+   */
+  template <typename T> static const Kernels<T> &kernels() {
+    return kernels<T>(level());
+  }
+
+  /**
+   * @brief Pack a transform for the apply kernel
+   *
+   * @param tx affine transform
+   * @param m rotation (row-major) followed by translation
+   */
+  template <typename T>
+  static void pack(const Eigen::Transform<double, 3, Eigen::Affine> &tx,
+                   T (&m)[12]) {
+    for (int r = 0; r < 3; ++r) {
+      for (int c = 0; c < 3; ++c) {
+        m[3 * r + c] = static_cast<T>(tx.linear()(r, c));
+      }
+      m[9 + r] = static_cast<T>(tx.translation()(r));
+    }
+  }
+  /**
+   * @brief Transform structure i of in into structure j of out
+   *
+   * @param tx affine transform
+   * @param in input coordinates
+   * @param i input structure
+   * @param out output coordinates (same number of atoms)
+   * @param j output structure
+   */
+  template <typename T>
+  static void apply(const Eigen::Transform<double, 3, Eigen::Affine> &tx,
+                    const SoA<T> &in, const size_t i, SoA<T> &out,
+                    const size_t j) {
+    assert(in.natoms() == out.natoms());
+    T m[12];
+    pack(tx, m);
+    kernels<T>().apply(m, in.x(i), in.y(i), in.z(i), in.natoms(), out.x(j),
+                       out.y(j), out.z(j));
+  }
+  /**
+   * @brief Sum of squared deviations between structures a[i] and b[j]
+   *
+   * @return sum of squared deviations
+   */
+  template <typename T>
+  static T deviation2(const SoA<T> &a, const size_t i, const SoA<T> &b,
+                      const size_t j) {
+    assert(a.natoms() == b.natoms());
+    return kernels<T>().deviation2(a.x(i), a.y(i), a.z(i), b.x(j), b.y(j),
+                                   b.z(j), a.natoms());
+  }
+  /**
+   * @brief Per atom squared distances between structures a[i] and b[j]
+   *
+   * @param out natoms squared distances
+   */
+  template <typename T>
+  static void distance2(const SoA<T> &a, const size_t i, const SoA<T> &b,
+                        const size_t j, T *out) {
+    assert(a.natoms() == b.natoms());
+    kernels<T>().distance2(a.x(i), a.y(i), a.z(i), b.x(j), b.y(j), b.z(j),
+                           a.natoms(), out);
+  }
+};
+
+} // namespace zdock
@@ -28,29 +28,51 @@
 #include "Exception.hpp"
 #include "Utils.hpp"
 #include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <unordered_set>
 
 namespace p = ::libpdb;
 namespace e = ::Eigen;
 
 namespace zdock {
 
-PDB::PDB() : filter_([](const libpdb::PDB &) { return true; }) {}
+template <typename T>
+PDBT<T>::PDBT()
+    : dirty_(false), stale_(true),
+      filter_([](const libpdb::PDB &) { return true; }) {}
 
-PDB::PDB(const PDB &p) {
+template <typename T>
+PDBT<T>::PDBT(const PDBT &p) : dirty_(false), stale_(true) {
+  p.sync_();
   models_ = p.models_;
   records_ = p.records_;
   atoms_ = p.atoms_;
   matrix_ = p.matrix_;
 }
 
-PDB::PDB(const std::string &filename,
+template <typename T>
+PDBT<T>::PDBT(const std::string &filename,
          std::function<bool(const libpdb::PDB &)> filter)
-    : filter_(filter) {
+    : dirty_(false), stale_(true), filter_(filter) {
   read_(filename);
+  index_();
 }
 
-PDB &PDB::operator=(const PDB &p) {
+template <typename T>
+PDBT<T>::PDBT(const std::string &filename, const Selection &selection)
+    : dirty_(false), stale_(true),
+      filter_([](const libpdb::PDB &) { return true; }) {
+  read_(filename);
+  select_(selection);
+  index_();
+}
+
+template <typename T>
+PDBT<T> &PDBT<T>::operator=(const PDBT &p) {
+  p.sync_();
+  dirty_ = false;
+  stale_ = true;
   models_ = p.models_;
   records_ = p.records_;
   atoms_ = p.atoms_;
@@ -58,7 +80,8 @@ PDB &PDB::operator=(const PDB &p) {
   return *this;
 }
 
-void PDB::read_(const std::string &fn) {
+template <typename T>
+void PDBT<T>::read_(const std::string &fn) {
   p::PDB record;
   size_t m = 0;
   std::ifstream infile(fn);
@@ -72,7 +95,7 @@ void PDB::read_(const std::string &fn) {
         m = record.model.num;
         while (models_.size() < m) {
           // TODO: probably make this a map instead...
-          models_.push_back(std::make_shared<zdock::Model>());
+          models_.push_back(std::make_shared<ModelT<T>>());
         }
         break;
       case p::PDB::ENDMDL:
@@ -90,12 +113,57 @@ void PDB::read_(const std::string &fn) {
   }
 }
 
-void PDB::append(const libpdb::PDB &record, const int model) {
+template <typename T>
+void PDBT<T>::select_(const Selection &selection) {
+  for (const auto &m : models_) {
+    m->select_(selection);
+  }
+  if (selection.isall()) {
+    return; // nothing to do
+  }
+  sync_();
+  if (!atoms_.empty()) {
+    const std::vector<char> mask = selection.mask(AtomTable(atoms_));
+    std::vector<Record> atoms;
+    for (size_t i = 0; i < atoms_.size(); ++i) {
+      if (mask[i]) {
+        matrix_.col(atoms.size()) = matrix_.col(i);
+        atoms.push_back(atoms_[i]);
+      }
+    }
+    matrix_.conservativeResize(e::NoChange, atoms.size());
+    atoms_.swap(atoms);
+  }
+  // drop unselected atom records (also those of models); other records stay
+  std::unordered_set<const libpdb::PDB *> selected;
+  for (const auto &a : atoms_) {
+    selected.insert(a.get());
+  }
+  for (const auto &m : models_) {
+    for (const auto &a : m->atoms_) {
+      selected.insert(a.get());
+    }
+  }
+  records_.erase(std::remove_if(records_.begin(), records_.end(),
+                                [&selected](const Record &r) {
+                                  return (p::PDB::ATOM == r->type() ||
+                                          p::PDB::HETATM == r->type()) &&
+                                         !selected.count(r.get());
+                                }),
+                 records_.end());
+  stale_ = true;
+}
+
+template <typename T>
+void PDBT<T>::append(const libpdb::PDB &record, const int model) {
   append(std::make_shared<libpdb::PDB>(record), model);
 }
 
-void PDB::append(const Record &r, const int model) {
+template <typename T>
+void PDBT<T>::append(const Record &r, const int model) {
+  sync_(); // records up to date before matrix_ grows
   std::lock_guard<std::mutex> lock(lock_);
+  stale_ = true;
   switch (r->type()) {
   case p::PDB::UNKNOWN:
     break; // silently drop 'UNKNOWN' type records
@@ -105,7 +173,7 @@ void PDB::append(const Record &r, const int model) {
       if (0 == model) {
         atoms_.push_back(r);
         matrix_.conservativeResize(matrix_.rows(), matrix_.cols() + 1);
-        matrix_.col(matrix_.cols() - 1) = e::Vector3d(r->atom.xyz);
+        matrix_.col(matrix_.cols() - 1) = e::Vector3d(r->atom.xyz).cast<T>();
       } else {
         models_[model - 1]->append(r);
         models_[model - 1]->modelNum_ = model;
@@ -120,37 +188,75 @@ void PDB::append(const Record &r, const int model) {
   }
 }
 
-const PDB::Matrix &PDB::matrix() const {
+template <typename T>
+const typename PDBT<T>::Matrix &PDBT<T>::matrix() const {
   if (models_.size() > 0) {
     return models_[0]->matrix(); // first model
   }
   return matrix_; // only model
 }
 
-const PDB::Matrix &PDB::setMatrix(const Matrix &m) {
+template <typename T>
+const typename PDBT<T>::Matrix &PDBT<T>::setMatrix(const Matrix &m) {
+  return setMatrix(Matrix(m));
+}
+
+template <typename T>
+const typename PDBT<T>::Matrix &PDBT<T>::setMatrix(Matrix &&m) {
   if (models_.size() > 0) {
-    return models_[0]->setMatrix(m); // first model
-  } else {                           // only model
+    return models_[0]->setMatrix(std::move(m)); // first model
+  } else {                                      // only model
     std::lock_guard<std::mutex> lock(lock_);
     assert(m.cols() == static_cast<long>(atoms_.size()));
-    for (size_t i = 0; i < atoms_.size(); ++i) {
-      atoms_[i]->atom.xyz[0] = m(0, i);
-      atoms_[i]->atom.xyz[1] = m(1, i);
-      atoms_[i]->atom.xyz[2] = m(2, i);
-    }
+    matrix_ = std::move(m);
+    dirty_ = true;
+    stale_ = true;
     return matrix_;
   }
 }
 
-const std::vector<PDB::Model> &PDB::models() const { return models_; }
+template <typename T>
+void PDBT<T>::sync_() const {
+  for (const auto &m : models_) {
+    m->sync_();
+  }
+  if (dirty_) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (dirty_) {
+      for (size_t i = 0; i < atoms_.size(); ++i) {
+        atoms_[i]->atom.xyz[0] = matrix_(0, i);
+        atoms_[i]->atom.xyz[1] = matrix_(1, i);
+        atoms_[i]->atom.xyz[2] = matrix_(2, i);
+      }
+      dirty_ = false;
+    }
+  }
+}
 
-size_t PDB::nmodels() const { return models_.size(); }
+template <typename T>
+const std::vector<typename PDBT<T>::Model> &PDBT<T>::models() const {
+  return models_;
+}
 
-const std::vector<PDB::Record> &PDB::records() const { return records_; }
+template <typename T>
+size_t PDBT<T>::nmodels() const { return models_.size(); }
 
-const std::vector<PDB::Record> &PDB::atoms() const { return atoms_; }
+template <typename T>
+const std::vector<typename PDBT<T>::Record> &PDBT<T>::records() const {
+  sync_();
+  return records_;
+}
+
+template <typename T>
+const std::vector<typename PDBT<T>::Record> &PDBT<T>::atoms() const {
+  sync_();
+  return atoms_;
+}
 
-const PDB::Record &PDB::operator[](const int serial) const {
+template <typename T>
+const typename PDBT<T>::Record &
+PDBT<T>::operator[](const int serial) const {
+  sync_();
   for (const auto &a : atoms_) {
     if (serial == a->atom.serialNum) {
       return a;
@@ -159,7 +265,9 @@ const PDB::Record &PDB::operator[](const int serial) const {
   throw AtomNotFoundException("Atom not found.");
 }
 
-const PDB::Record &PDB::operator[](const RecordCoord &coord) const {
+template <typename T>
+const typename PDBT<T>::Record &
+PDBT<T>::operator[](const RecordCoord &coord) const {
   const Record &x = (*this)[coord.serialNum];
   if (Utils::trim_copy(x->atom.name) == coord.atomName &&
       Utils::trim_copy(x->atom.residue.name) == coord.resName &&
@@ -171,8 +279,88 @@ const PDB::Record &PDB::operator[](const RecordCoord &coord) const {
   }
 }
 
-PDB::Coord PDB::centroid() const  {
+template <typename T>
+typename PDBT<T>::Coord PDBT<T>::centroid() const  {
   return matrix().rowwise().mean();
 }
 
+template <typename T>
+void PDBT<T>::index_() const {
+  for (const auto &m : models_) {
+    m->index_();
+  }
+  if (!stale_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!stale_) {
+    return;
+  }
+  chains_.clear();
+  residues_.clear();
+  for (size_t i = 0; i < atoms_.size(); ++i) {
+    const p::PDB::Residue &r = atoms_[i]->atom.residue;
+    if (residues_.empty() || residues_.back().chain != r.chainId ||
+        residues_.back().seqNum != r.seqNum ||
+        residues_.back().insertCode != r.insertCode) {
+      // new residue
+      if (!residues_.empty()) {
+        residues_.back().end = i;
+      }
+      ResidueRange x;
+      x.begin = i;
+      x.end = atoms_.size();
+      x.chain = r.chainId;
+      x.seqNum = r.seqNum;
+      x.insertCode = r.insertCode;
+      x.name = AtomTable::pack(r.name);
+      if (chains_.empty() || chains_.back().chain != r.chainId) {
+        // new chain
+        if (!chains_.empty()) {
+          chains_.back().end = residues_.size();
+        }
+        ChainRange c;
+        c.begin = residues_.size();
+        c.chain = r.chainId;
+        chains_.push_back(c);
+      }
+      residues_.push_back(x);
+    }
+  }
+  if (!chains_.empty()) {
+    chains_.back().end = residues_.size();
+  }
+  // residue centroids and bounding radii
+  for (auto &x : residues_) {
+    const e::Matrix<double, 3, e::Dynamic> block =
+        matrix_.middleCols(x.begin, x.size()).template cast<double>();
+    x.centroid = block.rowwise().mean();
+    x.radius = std::sqrt(
+        (block.colwise() - x.centroid).colwise().squaredNorm().maxCoeff());
+  }
+  stale_ = false;
+}
+
+template <typename T>
+const std::vector<ChainRange> &PDBT<T>::chains() const {
+  if (models_.size() > 0) {
+    return models_[0]->chains(); // first model
+  }
+  index_();
+  return chains_;
+}
+
+template <typename T>
+const std::vector<ResidueRange> &PDBT<T>::residues() const {
+  if (models_.size() > 0) {
+    return models_[0]->residues(); // first model
+  }
+  index_();
+  return residues_;
+}
+
+// explicit instantiations; double and single precision coordinates
+template class PDBT<double>;
+template class PDBT<float>;
+
 } // namespace zdock
@@ -0,0 +1,362 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Selection.hpp"
+#include "CellList.hpp"
+#include "Exception.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <set>
+
+namespace zdock {
+
+uint32_t AtomTable::pack(const char *s, const size_t n) {
+  uint32_t ret = 0;
+  for (size_t i = 0; i < n && '\0' != s[i]; ++i) {
+    if (!std::isspace(static_cast<unsigned char>(s[i]))) {
+      ret = (ret << 8) | static_cast<unsigned char>(s[i]);
+    }
+  }
+  return ret;
+}
+
+AtomTable::AtomTable(const std::vector<std::shared_ptr<libpdb::PDB>> &atoms) {
+  const size_t n = atoms.size();
+  chain.resize(n);
+  resSeq.resize(n);
+  name.resize(n);
+  resName.resize(n);
+  element.resize(n);
+  flags.resize(n);
+  xyz.resize(3, n);
+  for (size_t i = 0; i < n; ++i) {
+    const libpdb::PDB::Atom &a = atoms[i]->atom;
+    chain[i] = a.residue.chainId;
+    resSeq[i] = a.residue.seqNum;
+    name[i] = pack(a.name);
+    resName[i] = pack(a.residue.name);
+    element[i] = pack(a.element, 2);
+    flags[i] = (libpdb::PDB::HETATM == atoms[i]->type() ? HETATM : 0);
+    // hydrogen by element, or by atom name if no element was given
+    const char *nm = a.name;
+    while (std::isspace(static_cast<unsigned char>(*nm)) ||
+           std::isdigit(static_cast<unsigned char>(*nm))) {
+      ++nm;
+    }
+    if ('H' == element[i] || 'D' == element[i] ||
+        (0 == element[i] && ('H' == *nm || 'D' == *nm))) {
+      flags[i] |= HYDROGEN;
+    }
+    xyz.col(i) << a.xyz[0], a.xyz[1], a.xyz[2];
+  }
+}
+
+/**
+ * @brief split selection expression into tokens
+ *
+ * @param s expression
+ * @return tokens; parentheses are separate tokens
+ */
+static std::vector<std::string> tokenize(const std::string &s) {
+  std::vector<std::string> ret;
+  std::string tok;
+  for (const char c : s) {
+    if (std::isspace(static_cast<unsigned char>(c)) || '(' == c || ')' == c) {
+      if (!tok.empty()) {
+        ret.push_back(tok);
+        tok.clear();
+      }
+      if (!std::isspace(static_cast<unsigned char>(c))) {
+        ret.push_back(std::string(1, c));
+      }
+    } else {
+      tok += c;
+    }
+  }
+  if (!tok.empty()) {
+    ret.push_back(tok);
+  }
+  return ret;
+}
+
+//! reserved words that terminate a value list
+static bool iskeyword(const std::string &s) {
+  static const std::set<std::string> keywords = {
+      "and",   "or",       "not",    "within", "of",   "all",
+      "none",  "hydrogen", "hetatm", "chain",  "name", "resn",
+      "resi",  "element",  "(",      ")"};
+  return keywords.count(s) > 0;
+}
+
+Selection::Selection(const std::string &expr) : expr_(expr), root_(-1) {
+  const std::vector<std::string> t = tokenize(expr);
+  size_t i = 0;
+  if (t.empty()) {
+    throw SelectionException("Empty selection");
+  }
+  root_ = parseOr_(t, i);
+  if (i != t.size()) {
+    throw SelectionException("Unexpected '" + t[i] + "' in selection '" +
+                             expr + "'");
+  }
+}
+
+int Selection::node_(const Type type, const int lhs, const int rhs) {
+  Node n;
+  n.type = type;
+  n.distance = 0.0;
+  n.lhs = lhs;
+  n.rhs = rhs;
+  nodes_.push_back(n);
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+int Selection::parseOr_(const std::vector<std::string> &t, size_t &i) {
+  int lhs = parseAnd_(t, i);
+  while (i < t.size() && "or" == t[i]) {
+    ++i;
+    const int rhs = parseAnd_(t, i);
+    lhs = node_(OR, lhs, rhs);
+  }
+  return lhs;
+}
+
+int Selection::parseAnd_(const std::vector<std::string> &t, size_t &i) {
+  int lhs = parseFactor_(t, i);
+  while (i < t.size() && "and" == t[i]) {
+    ++i;
+    const int rhs = parseFactor_(t, i);
+    lhs = node_(AND, lhs, rhs);
+  }
+  return lhs;
+}
+
+int Selection::parseFactor_(const std::vector<std::string> &t, size_t &i) {
+  if (i >= t.size()) {
+    throw SelectionException("Unexpected end of selection '" + expr_ + "'");
+  }
+  const std::string &k = t[i++];
+  if ("not" == k) {
+    const int lhs = parseFactor_(t, i);
+    return node_(NOT, lhs);
+  } else if ("(" == k) {
+    const int ret = parseOr_(t, i);
+    if (i >= t.size() || ")" != t[i]) {
+      throw SelectionException("Missing ')' in selection '" + expr_ + "'");
+    }
+    ++i;
+    return ret;
+  } else if ("within" == k) {
+    char *end;
+    if (i + 1 >= t.size() || "of" != t[i + 1]) {
+      throw SelectionException("Expected 'within <distance> of' in '" +
+                               expr_ + "'");
+    }
+    const double d = std::strtod(t[i].c_str(), &end);
+    if ('\0' != *end || d < 0.0) {
+      throw SelectionException("Invalid distance '" + t[i] + "'");
+    }
+    i += 2;
+    const int lhs = parseFactor_(t, i);
+    const int ret = node_(WITHIN, lhs);
+    nodes_[ret].distance = d;
+    return ret;
+  } else if ("all" == k) {
+    return node_(ALL);
+  } else if ("none" == k) {
+    return node_(NONE);
+  } else if ("hydrogen" == k) {
+    return node_(HYDROGEN);
+  } else if ("hetatm" == k) {
+    return node_(HETATM);
+  }
+
+  // keywords followed by one or more values
+  Type type;
+  if ("chain" == k) {
+    type = CHAIN;
+  } else if ("name" == k) {
+    type = NAME;
+  } else if ("resn" == k) {
+    type = RESN;
+  } else if ("element" == k) {
+    type = ELEMENT;
+  } else if ("resi" == k) {
+    type = RESI;
+  } else {
+    throw SelectionException("Unknown keyword '" + k + "' in selection '" +
+                             expr_ + "'");
+  }
+  const int ret = node_(type);
+  Node &n = nodes_[ret];
+  while (i < t.size() && !iskeyword(t[i])) {
+    const std::string &v = t[i++];
+    if (RESI == type) {
+      // N, N-M or N:M (N and M may be negative)
+      char *end;
+      const long a = std::strtol(v.c_str(), &end, 10);
+      long b = a;
+      if (end == v.c_str()) {
+        throw SelectionException("Invalid residue number '" + v + "'");
+      }
+      if ('-' == *end || ':' == *end) {
+        const char *s = end + 1;
+        b = std::strtol(s, &end, 10);
+        if (end == s) {
+          throw SelectionException("Invalid residue range '" + v + "'");
+        }
+      }
+      if ('\0' != *end) {
+        throw SelectionException("Invalid residue range '" + v + "'");
+      }
+      n.range.push_back(std::make_pair(static_cast<int>(std::min(a, b)),
+                                       static_cast<int>(std::max(a, b))));
+    } else if (CHAIN == type) {
+      if (1 != v.size()) {
+        throw SelectionException("Invalid chain '" + v + "'");
+      }
+      n.values.push_back(static_cast<unsigned char>(v[0]));
+    } else {
+      if (v.size() > 4) {
+        throw SelectionException("Invalid name '" + v + "'");
+      }
+      n.values.push_back(AtomTable::pack(v.c_str()));
+    }
+  }
+  if (n.values.empty() && n.range.empty()) {
+    throw SelectionException("Expected value after '" + k +
+                             "' in selection '" + expr_ + "'");
+  }
+  return ret;
+}
+
+/**
+ * @brief test membership in a (short) list of packed values
+ */
+static inline bool contains(const std::vector<uint32_t> &v, const uint32_t x) {
+  for (const uint32_t y : v) {
+    if (x == y) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Selection::eval_(const int node, const AtomTable &t,
+                      std::vector<char> &m) const {
+  const Node &n = nodes_[node];
+  const size_t sz = t.size();
+  m.assign(sz, 0);
+  switch (n.type) {
+  case ALL:
+    m.assign(sz, 1);
+    break;
+  case NONE:
+    break;
+  case HYDROGEN:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = !!(t.flags[i] & AtomTable::HYDROGEN);
+    }
+    break;
+  case HETATM:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = !!(t.flags[i] & AtomTable::HETATM);
+    }
+    break;
+  case CHAIN:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = contains(n.values, static_cast<unsigned char>(t.chain[i]));
+    }
+    break;
+  case NAME:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = contains(n.values, t.name[i]);
+    }
+    break;
+  case RESN:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = contains(n.values, t.resName[i]);
+    }
+    break;
+  case ELEMENT:
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = contains(n.values, t.element[i]);
+    }
+    break;
+  case RESI:
+    for (size_t i = 0; i < sz; ++i) {
+      for (const auto &r : n.range) {
+        if (t.resSeq[i] >= r.first && t.resSeq[i] <= r.second) {
+          m[i] = 1;
+          break;
+        }
+      }
+    }
+    break;
+  case NOT:
+    eval_(n.lhs, t, m);
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = !m[i];
+    }
+    break;
+  case AND:
+  case OR: {
+    std::vector<char> r;
+    eval_(n.lhs, t, m);
+    eval_(n.rhs, t, r);
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = (AND == n.type ? m[i] && r[i] : m[i] || r[i]);
+    }
+    break;
+  }
+  case WITHIN: {
+    // bin the inner selection; cells of size d cover all candidates
+    std::vector<char> r;
+    eval_(n.lhs, t, r);
+    const double d2 = n.distance * n.distance;
+    CellList cells(std::max(n.distance, 1e-3));
+    for (size_t i = 0; i < sz; ++i) {
+      if (r[i]) {
+        cells.insert(t.xyz.col(i), i);
+      }
+    }
+    for (size_t i = 0; i < sz; ++i) {
+      m[i] = !cells.forEachNeighbor(t.xyz.col(i), [&](const size_t j) {
+        return (t.xyz.col(i) - t.xyz.col(j)).squaredNorm() > d2;
+      });
+    }
+    break;
+  }
+  }
+}
+
+std::vector<char> Selection::mask(const AtomTable &t) const {
+  std::vector<char> ret;
+  eval_(root_, t, ret);
+  return ret;
+}
+
+} // namespace zdock
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FCC.hpp"
+#include "Exception.hpp"
+#include "Parallel.hpp"
+#include <algorithm>
+
+namespace zdock {
+
+// residue index of every atom
+static std::vector<uint32_t> residueIndex(const PDB &pdb) {
+  std::vector<uint32_t> ret(pdb.matrix().cols());
+  const auto &residues = pdb.residues();
+  for (size_t r = 0; r < residues.size(); ++r) {
+    for (size_t a = residues[r].begin; a < residues[r].end; ++a) {
+      ret[a] = r;
+    }
+  }
+  return ret;
+}
+
+FCC::FCC(const PDB &receptor, const PDB &ligand, const double distance)
+    : receptor_(receptor.matrix()), recres_(residueIndex(receptor)),
+      ligand_(ligand.matrix()), ligres_(residueIndex(ligand)),
+      nligres_(ligand.residues().size()), distance_(distance),
+      cells_(distance) {
+  if (!receptor_.cols() || !ligand_.cols()) {
+    throw FCCException("Empty receptor or ligand");
+  }
+  if (distance <= 0.0) {
+    throw FCCException("Invalid contact distance");
+  }
+  if (static_cast<double>(receptor.residues().size()) * nligres_ >
+      static_cast<double>(UINT32_MAX)) {
+    throw FCCException("Too many residues");
+  }
+  for (Eigen::Index i = 0; i < receptor_.cols(); ++i) {
+    cells_.insert(receptor_.col(i), i);
+  }
+  lower_ = receptor_.rowwise().minCoeff().array() - distance;
+  upper_ = receptor_.rowwise().maxCoeff().array() + distance;
+}
+
+std::vector<uint32_t> FCC::contacts(const Transform &tx) const {
+  std::vector<uint32_t> ret;
+  const double d2 = distance_ * distance_;
+  const PDB::Matrix lig = tx * ligand_;
+  for (Eigen::Index a = 0; a < lig.cols(); ++a) {
+    const Eigen::Vector3d p = lig.col(a);
+    if ((p.array() < lower_.array()).any() ||
+        (p.array() > upper_.array()).any()) {
+      continue; // nowhere near the receptor
+    }
+    cells_.forEachNeighbor(p, [&](const size_t r) {
+      if ((receptor_.col(r) - p).squaredNorm() <= d2) {
+        ret.push_back(recres_[r] * nligres_ + ligres_[a]);
+      }
+      return true;
+    });
+  }
+  std::sort(ret.begin(), ret.end());
+  ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+  return ret;
+}
+
+FCC::Fingerprints FCC::fingerprints(const TransformUtil::Transforms &tx,
+                                    const size_t nthreads) const {
+  // contacts of all poses
+  std::vector<std::vector<uint32_t>> contacts(tx.size());
+  Parallel::forRange(tx.size(), nthreads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      contacts[i] = this->contacts(tx[i]);
+    }
+  });
+
+  // union of all contacts defines the bits
+  std::vector<uint32_t> all;
+  for (const auto &c : contacts) {
+    all.insert(all.end(), c.begin(), c.end());
+  }
+  std::sort(all.begin(), all.end());
+  all.erase(std::unique(all.begin(), all.end()), all.end());
+
+  // fill bitsets
+  Fingerprints f;
+  f.words_ = (all.size() + 63) / 64;
+  f.bits_.assign(f.words_ * tx.size(), 0);
+  f.counts_.resize(tx.size());
+  Parallel::forRange(tx.size(), nthreads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t *bits = f.bits_.data() + i * f.words_;
+      for (const uint32_t c : contacts[i]) {
+        const size_t b = std::lower_bound(all.begin(), all.end(), c) -
+                         all.begin();
+        bits[b / 64] |= uint64_t(1) << (b % 64);
+      }
+      f.counts_[i] = contacts[i].size();
+      std::vector<uint32_t>().swap(contacts[i]);
+    }
+  });
+  return f;
+}
+
+} // namespace zdock
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "CellList.hpp"
+#include "PDB.hpp"
+#include "TransformUtil.hpp"
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Residue contact fingerprints for fraction of common contacts (FCC)
+ *
+ * A contact is a pair of receptor and ligand residues with any two atoms
+ * within a distance cutoff (5 A by default). Contacts of a pose are found
+ * with a cell list over the receptor atoms. The similarity of two poses is
+ * the strict FCC, the number of common contacts over the larger number of
+ * contacts of either pose, i.e. the minimum of the FCC in both directions.
+ *
+ * Rodrigues JP, Trellet M, Schmitz C, Kastritis P, Karaca E, Melquiond AS,
+ * Bonvin AM. (2012) Clustering biomolecular complexes by residue contacts
+ * similarity. Proteins 80(7):1810-1817
+ */
+class FCC {
+public:
+  //! rigid-body transform
+  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+
+  /**
+   * @brief Contact bitsets of many poses, in one contiguous buffer
+   *
+   * Bits index the union of all contacts seen in any of the poses, so the
+   * bitsets stay short even for large receptors and ligands.
+   */
+  class Fingerprints {
+    friend class FCC;
+    size_t words_;                 // 64 bit words per pose
+    std::vector<uint64_t> bits_;   // words_ words per pose
+    std::vector<uint32_t> counts_; // number of contacts per pose
+
+  public:
+    Fingerprints() : words_(0) {}
+    //! number of poses
+    size_t size() const { return counts_.size(); }
+    //! number of 64 bit words per pose
+    size_t words() const { return words_; }
+    //! number of contacts of pose i
+    size_t count(const size_t i) const { return counts_[i]; }
+    //! number of contacts common to poses i and j
+    size_t common(const size_t i, const size_t j) const {
+      const uint64_t *a = bits_.data() + i * words_;
+      const uint64_t *b = bits_.data() + j * words_;
+      size_t c = 0;
+      for (size_t w = 0; w < words_; ++w) {
+        c += __builtin_popcountll(a[w] & b[w]);
+      }
+      return c;
+    }
+    /**
+     * @brief Strict FCC between poses i and j
+     *
+     * @return common contacts over the larger contact count (0 if neither
+     * pose has contacts)
+     */
+    double similarity(const size_t i, const size_t j) const {
+      const size_t m = std::max(counts_[i], counts_[j]);
+      return m ? static_cast<double>(common(i, j)) / m : 0.0;
+    }
+  };
+
+private:
+  PDB::Matrix receptor_;          // receptor coordinates
+  std::vector<uint32_t> recres_;  // receptor residue per atom
+  PDB::Matrix ligand_;            // ligand coordinates (input frame)
+  std::vector<uint32_t> ligres_;  // ligand residue per atom
+  uint32_t nligres_;              // number of ligand residues
+  double distance_;               // contact distance
+  CellList cells_;                // receptor atoms
+  Eigen::Vector3d lower_, upper_; // receptor bounding box, plus distance
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param receptor receptor structure
+   * @param ligand ligand structure, as input to ZDOCK
+   * @param distance contact distance
+   */
+  FCC(const PDB &receptor, const PDB &ligand, const double distance = 5.0);
+
+  /**
+   * @brief Contacts of a single pose
+   *
+   * @param tx transform taking input ligand coordinates to the pose
+   * @return sorted contact ids (receptor residue * ligand residues + ligand
+   * residue)
+   */
+  std::vector<uint32_t> contacts(const Transform &tx) const;
+
+  /**
+   * @brief Contact fingerprints of many poses
+   *
+   * @param tx transforms taking input ligand coordinates to the poses
+   * @param nthreads number of threads (0 for all hardware threads)
+   * @return fingerprints, one per transform
+   */
+  Fingerprints fingerprints(const TransformUtil::Transforms &tx,
+                            const size_t nthreads = 0) const;
+};
+
+} // namespace zdock
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NeighborGraph.hpp"
+#include "Exception.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace zdock {
+
+// file magic and format version
+static const char MAGIC[8] = {'Z', 'D', 'N', 'G', 'R', 'A', 'P', 'H'};
+static const uint32_t VERSION = 1;
+
+NeighborGraph::NeighborGraph(const size_t size, const double cutoff,
+                             const uint64_t key)
+    : size_(size), cutoff_(cutoff), key_(key), offsets_(1, 0) {
+  if (size > UINT32_MAX) {
+    throw NeighborGraphException("Too many predictions");
+  }
+}
+
+void NeighborGraph::add(const size_t j, const double distance) {
+  if (j <= nrows() || j >= size_) {
+    throw NeighborGraphException("Invalid neighbor");
+  }
+  neighbors_.push_back(j);
+  distances_.push_back(distance);
+}
+
+void NeighborGraph::next() {
+  if (nrows() >= size_) {
+    throw NeighborGraphException("Too many rows");
+  }
+  offsets_.push_back(neighbors_.size());
+}
+
+std::vector<int> NeighborGraph::cluster(const double cutoff) const {
+  if (nrows() != size_) {
+    throw NeighborGraphException("Incomplete graph");
+  }
+  if (cutoff > cutoff_) {
+    throw NeighborGraphException("Cutoff exceeds graph cutoff");
+  }
+  std::vector<int> l(size_, 0);
+  int clusters = 0;
+  for (size_t i = 0; i < size_; ++i) {
+    if (!l[i]) {
+      l[i] = ++clusters;
+      const uint32_t *j = neighbors(i);
+      const double *d = distances(i);
+      for (size_t k = 0; k < degree(i); ++k) {
+        if (!l[j[k]] && d[k] < cutoff) {
+          l[j[k]] = clusters;
+        }
+      }
+    }
+  }
+  return l;
+}
+
+// raw binary output of a value or an array
+template <typename T>
+static void write(std::ofstream &out, const T *v, const size_t n = 1) {
+  out.write(reinterpret_cast<const char *>(v), n * sizeof(T));
+}
+
+template <typename T>
+static void read(std::ifstream &in, T *v, const size_t n = 1) {
+  in.read(reinterpret_cast<char *>(v), n * sizeof(T));
+}
+
+void NeighborGraph::save(const std::string &fn) const {
+  if (nrows() != size_) {
+    throw NeighborGraphException("Incomplete graph");
+  }
+  std::ofstream out(fn, std::ios::binary);
+  if (!out) {
+    throw NeighborGraphException("Error opening '" + fn + "' for writing");
+  }
+  const uint64_t size = size_, nedges = neighbors_.size();
+  write(out, MAGIC, sizeof(MAGIC));
+  write(out, &VERSION);
+  write(out, &size);
+  write(out, &cutoff_);
+  write(out, &key_);
+  write(out, &nedges);
+  write(out, offsets_.data(), offsets_.size());
+  write(out, neighbors_.data(), neighbors_.size());
+  write(out, distances_.data(), distances_.size());
+  if (!out) {
+    throw NeighborGraphException("Error writing '" + fn + "'");
+  }
+}
+
+NeighborGraph NeighborGraph::load(const std::string &fn) {
+  std::ifstream in(fn, std::ios::binary);
+  if (!in) {
+    throw NeighborGraphException("Error opening '" + fn + "'");
+  }
+  char magic[sizeof(MAGIC)];
+  uint32_t version = 0;
+  uint64_t size = 0, key = 0, nedges = 0;
+  double cutoff = 0.0;
+  read(in, magic, sizeof(magic));
+  read(in, &version);
+  if (!in || std::memcmp(magic, MAGIC, sizeof(MAGIC)) || VERSION != version) {
+    throw NeighborGraphException("'" + fn + "' is not a neighbor graph");
+  }
+  read(in, &size);
+  read(in, &cutoff);
+  read(in, &key);
+  read(in, &nedges);
+  // only pairs j > i are stored, and the arrays must fit in the file
+  const std::streamoff header = in.tellg();
+  in.seekg(0, std::ios::end);
+  const std::streamoff length = in.tellg();
+  in.seekg(header);
+  if (!in || size > UINT32_MAX || nedges > size * (size - 1) / 2 ||
+      static_cast<uint64_t>(length - header) !=
+          (size + 1) * sizeof(uint64_t) +
+              nedges * (sizeof(uint32_t) + sizeof(double))) {
+    throw NeighborGraphException("Invalid neighbor graph '" + fn + "'");
+  }
+  NeighborGraph g(size, cutoff, key);
+  g.offsets_.resize(size + 1);
+  g.neighbors_.resize(nedges);
+  g.distances_.resize(nedges);
+  read(in, g.offsets_.data(), g.offsets_.size());
+  read(in, g.neighbors_.data(), g.neighbors_.size());
+  read(in, g.distances_.data(), g.distances_.size());
+  if (!in || g.offsets_.front() || nedges != g.offsets_.back()) {
+    throw NeighborGraphException("Invalid neighbor graph '" + fn + "'");
+  }
+  for (size_t i = 0; i < size; ++i) {
+    if (g.offsets_[i] > g.offsets_[i + 1]) {
+      throw NeighborGraphException("Invalid neighbor graph '" + fn + "'");
+    }
+    for (size_t k = g.offsets_[i]; k < g.offsets_[i + 1]; ++k) {
+      if (g.neighbors_[k] <= i || g.neighbors_[k] >= size) {
+        throw NeighborGraphException("Invalid neighbor graph '" + fn + "'");
+      }
+    }
+  }
+  return g;
+}
+
+// FNV-1a over raw bytes
+static uint64_t fnv1a(const void *data, const size_t n, uint64_t h) {
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  for (size_t k = 0; k < n; ++k) {
+    h ^= p[k];
+    h *= 1099511628211UL;
+  }
+  return h;
+}
+
+uint64_t NeighborGraph::key(const std::vector<Prediction> &predictions,
+                            const std::string &context) {
+  uint64_t h = 14695981039346656037UL;
+  h = fnv1a(context.data(), context.size(), h);
+  for (const auto &p : predictions) {
+    h = fnv1a(p.rotation, sizeof(p.rotation), h);
+    h = fnv1a(p.translation, sizeof(p.translation), h);
+  }
+  return h;
+}
+
+} // namespace zdock
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "ZDOCK.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Sparse graph of prediction pairs within a maximum distance
+ *
+ * Rows are predictions in score order; row i holds, in compressed sparse
+ * row form, every later prediction j > i whose distance (RMSD) to i is
+ * below the graph cutoff, together with that distance. Greedy clustering
+ * only ever compares a cluster center with later predictions, so the graph
+ * reproduces greedy clusters exactly at any cutoff up to the one it was
+ * built with.
+ *
+ * Graphs are saved to and loaded from a compact binary file. A key derived
+ * from the predictions (see key()) is stored with the graph so that it is
+ * not applied to other output.
+ */
+class NeighborGraph {
+private:
+  size_t size_;                     // number of predictions (rows)
+  double cutoff_;                   // maximum distance
+  uint64_t key_;                    // identifies the input
+  std::vector<uint64_t> offsets_;   // row offsets, one past each row
+  std::vector<uint32_t> neighbors_; // later predictions, per row
+  std::vector<double> distances_;   // distances, per row
+
+public:
+  /**
+   * @brief Constructor for an empty graph
+   *
+   * @param size number of predictions
+   * @param cutoff maximum distance of pairs in the graph
+   * @param key key of the input (see key())
+   */
+  NeighborGraph(const size_t size = 0, const double cutoff = 0.0,
+                const uint64_t key = 0);
+
+  /**
+   * @brief Add a pair to the current (last) row
+   *
+   * @param j later prediction
+   * @param distance distance, below the graph cutoff
+   */
+  void add(const size_t j, const double distance);
+  /**
+   * @brief Close the current row and start the next
+   */
+  void next();
+
+  //! number of predictions (rows)
+  size_t size() const { return size_; }
+  //! number of rows completed so far
+  size_t nrows() const { return offsets_.size() - 1; }
+  //! number of pairs
+  size_t nedges() const { return neighbors_.size(); }
+  //! maximum distance of pairs in the graph
+  double cutoff() const { return cutoff_; }
+  //! key of the input
+  uint64_t key() const { return key_; }
+  //! number of neighbors of prediction i
+  size_t degree(const size_t i) const {
+    return offsets_[i + 1] - offsets_[i];
+  }
+  //! later neighbors of prediction i, in prediction order
+  const uint32_t *neighbors(const size_t i) const {
+    return neighbors_.data() + offsets_[i];
+  }
+  //! distances to the neighbors of prediction i
+  const double *distances(const size_t i) const {
+    return distances_.data() + offsets_[i];
+  }
+
+  /**
+   * @brief Greedy clustering in prediction order
+   *
+   * @param cutoff distance cutoff, at most the graph cutoff
+   * @return cluster number (1-based) of every prediction
+   */
+  std::vector<int> cluster(const double cutoff) const;
+
+  /**
+   * @brief Write graph to a binary file
+   *
+   * @param fn file name
+   */
+  void save(const std::string &fn) const;
+  /**
+   * @brief Read graph from a binary file
+   *
+   * @param fn file name
+   * @return graph
+   */
+  static NeighborGraph load(const std::string &fn);
+
+  /**
+   * @brief Key identifying a set of predictions and how they are compared
+   *
+   * @param predictions predictions, in order
+   * @param context anything else the distances depend on (e.g. metric and
+   * atom selection)
+   * @return 64 bit hash (FNV-1a)
+   */
+  static uint64_t key(const std::vector<Prediction> &predictions,
+                      const std::string &context);
+};
+
+} // namespace zdock
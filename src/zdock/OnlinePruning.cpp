@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "OnlinePruning.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace zdock {
+
+OnlinePruning::OnlinePruning(const ZDOCK &zdock, const Matrix &structure,
+                             const double cutoff)
+    : ismzdock_(zdock.ismzdock()), txl_(zdock), txm_(zdock),
+      moments_(structure), cutoff_(cutoff),
+      bound2_(cutoff * (1.0 + 1e-3) * cutoff * (1.0 + 1e-3)),
+      grid_(cutoff * (1.0 + 1e-3)), count_(0) {}
+
+OnlinePruning::Assignment OnlinePruning::add(const Prediction &p) {
+  // embed pose (M-ZDOCK: first and third mer, as in batch pruning)
+  PoseRMSD::Point e0, e1;
+  if (ismzdock_) {
+    e0 = moments_.embed(txm_.transform(p, 0));
+    e1 = moments_.embed(txm_.transform(p, 2));
+  } else {
+    e0 = moments_.embed(txl_.transform(p));
+  }
+  const Eigen::Vector3d c0(e0[0], e0[1], e0[2]);
+  const Eigen::Vector3d c1(e1[0], e1[1], e1[2]);
+  count_++;
+
+  // representatives near either centroid, earliest first
+  std::vector<size_t> cand;
+  auto collect = [&cand](const size_t r) {
+    cand.push_back(r);
+    return true;
+  };
+  grid_.forEachNeighbor(c0, collect);
+  if (ismzdock_) {
+    grid_.forEachNeighbor(c1, collect);
+  }
+  std::sort(cand.begin(), cand.end());
+  cand.erase(std::unique(cand.begin(), cand.end()), cand.end());
+  for (const size_t r : cand) {
+    const PoseRMSD::Point &rep = reps_[r];
+    const Eigen::Vector3d cr(rep[0], rep[1], rep[2]);
+    if ((cr - c0).squaredNorm() > bound2_ &&
+        (!ismzdock_ || (cr - c1).squaredNorm() > bound2_)) {
+      continue; // cannot be within cutoff
+    }
+    double d = PoseRMSD::rmsd2(rep, e0);
+    if (ismzdock_) {
+      d = std::min(d, PoseRMSD::rmsd2(rep, e1));
+    }
+    if (std::sqrt(d) < cutoff_) {
+      return {static_cast<int>(r) + 1, false};
+    }
+  }
+
+  // new representative
+  grid_.insert(c0, reps_.size());
+  reps_.push_back(e0);
+  return {static_cast<int>(reps_.size()), true};
+}
+
+} // namespace zdock
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "CellList.hpp"
+#include "PoseRMSD.hpp"
+#include "TransformLigand.hpp"
+#include "TransformMultimer.hpp"
+#include "ZDOCK.hpp"
+#include <Eigen/Dense>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Incremental greedy RMSD clustering of predictions in score order
+ *
+ * Predictions are added one at a time, in the order they appear in
+ * (M-)ZDOCK output. A prediction joins the earliest cluster whose
+ * representative is within the RMSD cutoff, or else becomes the
+ * representative of a new cluster. This is exactly what the batch greedy
+ * algorithm in pruning computes for the same order, but every assignment is
+ * final as soon as the prediction is added.
+ *
+ * Only representatives are stored (as PoseRMSD embeddings, in a cell list
+ * over their centroids), so memory grows with the number of clusters rather
+ * than the number of predictions.
+ */
+class OnlinePruning {
+public:
+  //! coordinate matrix type
+  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+
+  /**
+   * @brief Result of adding a prediction
+   */
+  struct Assignment {
+    int cluster;         //!< cluster number (1-based)
+    bool representative; //!< prediction is the cluster's representative
+  };
+
+private:
+  const bool ismzdock_;               // M-ZDOCK (compare to both mers)
+  const TransformLigand txl_;         // ligand transformations
+  const TransformMultimer txm_;       // multimer transformations
+  const PoseRMSD moments_;            // pose embedding
+  const double cutoff_;               // RMSD cutoff
+  const double bound2_;               // squared centroid bound
+  CellList grid_;                     // representative centroids
+  std::vector<PoseRMSD::Point> reps_; // representative embeddings
+  size_t count_;                      // number of predictions added
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param zdock (M-)ZDOCK output; only the header is used, so a ZDOCK read
+   * from a stream will do
+   * @param structure ligand (M-ZDOCK: structure) coordinates of the atoms
+   * defining the RMSD, as input to (M-)ZDOCK
+   * @param cutoff RMSD cutoff
+   */
+  OnlinePruning(const ZDOCK &zdock, const Matrix &structure,
+                const double cutoff);
+
+  /**
+   * @brief Add the next prediction
+   *
+   * @param p prediction; predictions must be added in score order
+   * @return cluster assignment, final
+   */
+  Assignment add(const Prediction &p);
+
+  //! number of clusters (representatives)
+  size_t nclusters() const { return reps_.size(); }
+  //! number of predictions added
+  size_t size() const { return count_; }
+};
+
+} // namespace zdock
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PoseIndex.hpp"
+#include "Exception.hpp"
+#include "TransformLigand.hpp"
+#include "TransformMultimer.hpp"
+#include <Eigen/Geometry>
+#include <cmath>
+
+namespace zdock {
+
+// check for empty ligand before computing moments
+static const PoseIndex::Matrix &nonempty(const PoseIndex::Matrix &ligand) {
+  if (!ligand.cols()) {
+    throw PoseIndexException("Empty ligand");
+  }
+  return ligand;
+}
+
+PoseIndex::PoseIndex(const ZDOCK &zdock, const Matrix &ligand)
+    : ligand_(nonempty(ligand)), rmsd_(ligand) {
+  // embed all prediction poses
+  const auto &preds = zdock.predictions();
+  TransformUtil::Transforms tx;
+  if (zdock.ismzdock()) {
+    tx = TransformMultimer(zdock).transforms(preds, 0, preds.size(), 0);
+  } else {
+    tx = TransformLigand(zdock).transforms(preds, 0, preds.size());
+  }
+  tree_ = Tree(rmsd_.embed(tx));
+}
+
+std::vector<PoseIndex::Hit> PoseIndex::nearest(const Transform &tx,
+                                               const size_t k) const {
+  std::vector<Hit> ret;
+  for (const auto &x : tree_.nearest(rmsd_.embed(tx), k)) {
+    ret.push_back({x.second, std::sqrt(x.first)});
+  }
+  return ret;
+}
+
+std::vector<PoseIndex::Hit> PoseIndex::nearest(const Matrix &pose,
+                                               const size_t k) const {
+  if (pose.cols() != ligand_.cols()) {
+    throw PoseIndexException("Pose has " + std::to_string(pose.cols()) +
+                             " atoms; expected " +
+                             std::to_string(ligand_.cols()));
+  }
+  Transform tx;
+  tx.matrix() = Eigen::umeyama(ligand_, pose, false);
+  return nearest(tx, k);
+}
+
+} // namespace zdock
@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "KDTree.hpp"
+#include "PoseRMSD.hpp"
+#include "ZDOCK.hpp"
+#include <Eigen/Dense>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Nearest prediction lookup for arbitrary ligand poses
+ *
+ * Poses of all predictions are embedded with PoseRMSD, in which Euclidean
+ * distance equals RMSD exactly, and kept in a k-d tree. For M-ZDOCK the
+ * first mer is indexed.
+ */
+class PoseIndex {
+public:
+  //! rigid-body transform
+  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+  //! coordinate matrix type
+  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+
+  /**
+   * @brief Query result
+   */
+  struct Hit {
+    size_t index; //!< prediction index (0-based, as in ZDOCK::predictions())
+    double rmsd;  //!< RMSD between query and prediction pose
+  };
+
+private:
+  typedef KDTree<12> Tree;
+
+  Matrix ligand_; // ligand coordinates (input frame)
+  PoseRMSD rmsd_; // pose embedding
+  Tree tree_;     // embedded prediction poses
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param zdock (M-)ZDOCK output
+   * @param ligand ligand (M-ZDOCK: structure) coordinates, as input to
+   * (M-)ZDOCK, defining the RMSD
+   */
+  PoseIndex(const ZDOCK &zdock, const Matrix &ligand);
+
+  /**
+   * @brief Nearest predictions to a rigid-body transform
+   *
+   * @param tx transform taking input ligand coordinates to the query pose
+   * @param k number of predictions
+   * @return predictions, nearest first
+   */
+  std::vector<Hit> nearest(const Transform &tx, const size_t k = 1) const;
+  /**
+   * @brief Nearest predictions to a ligand pose
+   *
+   * The rigid-body transform is found by least-squares superposition of the
+   * input ligand onto the pose.
+   *
+   * @param pose ligand coordinates in the query pose (same atoms and order
+   * as the ligand used to build the index)
+   * @param k number of predictions
+   * @return predictions, nearest first
+   */
+  std::vector<Hit> nearest(const Matrix &pose, const size_t k = 1) const;
+
+  //! number of indexed predictions
+  size_t size() const { return tree_.size(); }
+};
+
+} // namespace zdock
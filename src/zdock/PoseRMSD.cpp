@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PoseRMSD.hpp"
+#include "Exception.hpp"
+#include <Eigen/Eigenvalues>
+#include <cmath>
+
+namespace zdock {
+
+PoseRMSD::PoseRMSD(const Matrix &structure) {
+  if (!structure.cols()) {
+    throw PoseRMSDException("Empty structure");
+  }
+  centroid_ = structure.rowwise().mean();
+  const Matrix x = structure.colwise() - centroid_;
+  const Eigen::Matrix3d s = x * x.transpose() / structure.cols();
+  const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig(s);
+  l_ = eig.eigenvectors() *
+       eig.eigenvalues().cwiseMax(0.0).cwiseSqrt().asDiagonal();
+}
+
+PoseRMSD::Point PoseRMSD::embed(const Transform &tx) const {
+  Point p;
+  const Eigen::Vector3d c = tx * centroid_;
+  const Eigen::Matrix3d m = tx.linear() * l_;
+  for (int i = 0; i < 3; ++i) {
+    p[i] = c(i);
+  }
+  for (int i = 0; i < 9; ++i) {
+    p[3 + i] = m(i);
+  }
+  return p;
+}
+
+std::vector<PoseRMSD::Point>
+PoseRMSD::embed(const TransformUtil::Transforms &tx) const {
+  std::vector<Point> ret;
+  ret.reserve(tx.size());
+  for (const auto &t : tx) {
+    ret.push_back(embed(t));
+  }
+  return ret;
+}
+
+double PoseRMSD::rmsd(const Transform &a, const Transform &b) const {
+  return std::sqrt(rmsd2(embed(a), embed(b)));
+}
+
+} // namespace zdock
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "TransformUtil.hpp"
+#include <Eigen/Dense>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Constant time RMSD between rigid-body poses of one structure
+ *
+ * The RMSD between two rigid-body poses (R1, t1) and (R2, t2) of the same
+ * structure depends only on the structure's centroid c and covariance S:
+ *
+ *     RMSD^2 = |(R1 - R2) c + t1 - t2|^2 + tr((R1 - R2) S (R1 - R2)')
+ *
+ * With S = L L', every pose maps to the 12 dimensional point
+ * (R c + t, R L), in which Euclidean distance equals RMSD exactly. The
+ * first three coordinates of a point are the pose centroid.
+ */
+class PoseRMSD {
+public:
+  //! rigid-body transform
+  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+  //! coordinate matrix type
+  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
+  //! embedded pose
+  typedef std::array<double, 12> Point;
+
+private:
+  Eigen::Vector3d centroid_; // structure centroid
+  Eigen::Matrix3d l_;        // S = L L'
+
+public:
+  /**
+   * @brief Constructor
+   *
+   * @param structure structure coordinates (input frame) defining the RMSD
+   */
+  PoseRMSD(const Matrix &structure);
+
+  /**
+   * @brief Embed a pose
+   *
+   * @param tx transform taking input coordinates to the pose
+   * @return embedded pose
+   */
+  Point embed(const Transform &tx) const;
+  /**
+   * @brief Embed many poses
+   *
+   * @param tx transforms taking input coordinates to the poses
+   * @return embedded poses, one per transform
+   */
+  std::vector<Point> embed(const TransformUtil::Transforms &tx) const;
+
+  /**
+   * @brief Squared RMSD between two embedded poses
+   *
+   * @param a first pose
+   * @param b second pose
+   * @return squared RMSD
+   */
+  static inline double rmsd2(const Point &a, const Point &b) {
+    double d = 0.0;
+    for (size_t i = 0; i < 12; ++i) {
+      d += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return d;
+  }
+  /**
+   * @brief Squared RMSD between a pose and the nearest of a cyclic set
+   *
+   * The minimum over the poses of b rotated about the z axis by multiples
+   * of 2 pi / symmetry (the mers of an M-ZDOCK multimer). In the embedding,
+   * a rotation about z acts on each of the four 3-vectors, so the overlap
+   * with a is C + A cos(t) + B sin(t), maximal at t = atan2(B, A); the
+   * nearest allowed angle gives the minimum.
+   *
+   * @param a first pose
+   * @param b second pose
+   * @param symmetry number of rotations (mers)
+   * @return squared RMSD
+   */
+  static inline double rmsd2(const Point &a, const Point &b,
+                             const int symmetry) {
+    double p = 0.0, q = 0.0;
+    for (size_t i = 0; i < 12; i += 3) {
+      p += a[i] * b[i] + a[i + 1] * b[i + 1];
+      q += a[i + 1] * b[i] - a[i] * b[i + 1];
+    }
+    const double beta = 2.0 * TransformUtil::PI / symmetry;
+    const double t = beta * std::round(std::atan2(q, p) / beta);
+    const double c = std::cos(t), s = std::sin(t);
+    double d = 0.0;
+    for (size_t i = 0; i < 12; i += 3) {
+      const double x = a[i] - (c * b[i] - s * b[i + 1]);
+      const double y = a[i + 1] - (s * b[i] + c * b[i + 1]);
+      const double z = a[i + 2] - b[i + 2];
+      d += x * x + y * y + z * z;
+    }
+    return d;
+  }
+  /**
+   * @brief RMSD between two poses
+   *
+   * @param a transform taking input coordinates to the first pose
+   * @param b transform taking input coordinates to the second pose
+   * @return RMSD
+   */
+  double rmsd(const Transform &a, const Transform &b) const;
+
+  //! get structure centroid
+  const Eigen::Vector3d &centroid() const { return centroid_; }
+};
+
+} // namespace zdock
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RotationCache.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace zdock {
+
+RotationCache::Key RotationCache::key_(const double (&r)[3]) {
+  Key k;
+  std::memcpy(k.r, r, sizeof(k.r));
+  return k;
+}
+
+RotationCache::RotationCache(const std::vector<Prediction> &predictions) {
+  // assign ids to distinct triples
+  std::vector<const double *> angles;
+  ids_.reserve(predictions.size());
+  for (const auto &p : predictions) {
+    const auto it = index_.emplace(key_(p.rotation),
+                                   static_cast<int>(angles.size()));
+    if (it.second) {
+      angles.push_back(p.rotation);
+    }
+    ids_.push_back(it.first->second);
+  }
+
+  // Z(phi) * X(theta) * Z(psi), once per distinct triple; std::sin and
+  // std::cos as in matrix(), so cached and uncached rotations are
+  // bitwise equal regardless of how Eigen vectorizes
+  rotations_.resize(angles.size());
+  for (size_t i = 0; i < angles.size(); ++i) {
+    const double *r = angles[i];
+    rotations_[i] = zxz_(std::sin(r[0]), std::sin(r[1]), std::sin(r[2]),
+                         std::cos(r[0]), std::cos(r[1]), std::cos(r[2]));
+  }
+}
+
+} // namespace zdock
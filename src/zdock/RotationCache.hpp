@@ -0,0 +1,161 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "TransformUtil.hpp"
+#include "ZDOCK.hpp"
+#include <Eigen/Dense>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace zdock {
+
+/**
+ * @brief Memoized Z-X-Z rotation matrices for a set of predictions
+ *
+ * ZDOCK samples rotations from a fixed set of Euler triples, so the same
+ * rotation occurs many times in a single output file. The cache assigns an
+ * id to each distinct triple and computes its matrix once.
+ */
+class RotationCache {
+private:
+  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+
+  // exact (bitwise) Euler triple
+  struct Key {
+    uint64_t r[3];
+    bool operator==(const Key &o) const {
+      return r[0] == o.r[0] && r[1] == o.r[1] && r[2] == o.r[2];
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key &k) const {
+      uint64_t h = k.r[0];
+      h = h * 0x9e3779b97f4a7c15ULL ^ k.r[1];
+      h = h * 0x9e3779b97f4a7c15ULL ^ k.r[2];
+      return static_cast<size_t>(h ^ (h >> 29));
+    }
+  };
+
+  static Key key_(const double (&r)[3]);
+
+  // Z(phi) * X(theta) * Z(psi) from sines and cosines of the Euler angles
+  static inline Eigen::Matrix3d zxz_(const double s0, const double s1,
+                                     const double s2, const double c0,
+                                     const double c1, const double c2) {
+    Eigen::Matrix3d m;
+    m << c0 * c2 - s0 * c1 * s2, -c0 * s2 - s0 * c1 * c2, s0 * s1,
+        s0 * c2 + c0 * c1 * s2, -s0 * s2 + c0 * c1 * c2, -c0 * s1, s1 * s2,
+        s1 * c2, c1;
+    return m;
+  }
+
+  std::unordered_map<Key, int, KeyHash> index_; // triple to rotation id
+  std::vector<Eigen::Matrix3d> rotations_;      // rotation matrices by id
+  std::vector<int> ids_;                        // rotation id per prediction
+
+public:
+  /**
+   * @brief Empty cache; all rotations are computed on lookup
+   */
+  RotationCache() {}
+  /**
+   * @brief Build cache for the rotations in a set of predictions
+   *
+   * @param predictions (M-)ZDOCK predictions
+   */
+  explicit RotationCache(const std::vector<Prediction> &predictions);
+
+  /**
+   * @brief Look up rotation id for an Euler triple
+   *
+   * @param r Euler angles (Z-X-Z)
+   * @return rotation id, or -1 if not cached
+   */
+  int id(const double (&r)[3]) const {
+    const auto it = index_.find(key_(r));
+    return it == index_.end() ? -1 : it->second;
+  }
+  /**
+   * @brief Rotation id for each prediction the cache was built from
+   *
+   * @return vector of rotation ids, in prediction order
+   */
+  const std::vector<int> &ids() const { return ids_; }
+  /**
+   * @brief Get rotation matrix by id
+   *
+   * @param id rotation id
+   * @return 3x3 rotation matrix
+   */
+  const Eigen::Matrix3d &rotation(const size_t id) const {
+    return rotations_[id];
+  }
+  /**
+   * @brief Get rotation matrix for an Euler triple
+   *
+   * @param r Euler angles (Z-X-Z)
+   * @return 3x3 rotation matrix; computed directly if not cached, with the
+   * same arithmetic as cached rotations, so results do not depend on the
+   * cache contents
+   */
+  const Eigen::Matrix3d matrix(const double (&r)[3]) const {
+    const int i = id(r);
+    if (i < 0) {
+      return zxz_(std::sin(r[0]), std::sin(r[1]), std::sin(r[2]),
+                  std::cos(r[0]), std::cos(r[1]), std::cos(r[2]));
+    }
+    return rotations_[i];
+  }
+  /**
+   * @brief Number of distinct rotations
+   *
+   * @return number of cached rotations
+   */
+  size_t size() const { return rotations_.size(); }
+  /**
+   * @brief Drop-in for TransformUtil::eulerRotation using the cache
+   *
+   * @param r Euler angles (Z-X-Z)
+   * @param rev reverse rotation
+   * @return rotation transform
+   */
+  const Transform eulerRotation(const double (&r)[3],
+                                const bool rev = false) const {
+    Transform t = Transform::Identity();
+    if (rev) {
+      t.linear() = matrix(r).transpose();
+    } else {
+      t.linear() = matrix(r);
+    }
+    return t;
+  }
+};
+
+} // namespace zdock
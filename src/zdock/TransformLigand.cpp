@@ -31,32 +31,87 @@ namespace p = libpdb;
 
 namespace zdock {
 
-TransformLigand::TransformLigand(const std::string &zdock)
-    : TransformLigand(ZDOCK(zdock)) {}
+template <typename T>
+TransformLigandT<T>::TransformLigandT(const std::string &zdock)
+    : TransformLigandT(ZDOCK(zdock)) {}
 
-TransformLigand::TransformLigand(const ZDOCK &zdock) : zdock_(zdock) {
+template <typename T>
+TransformLigandT<T>::TransformLigandT(const ZDOCK &zdock) : zdock_(zdock) {
 
-  using e::Translation3d;
   using e::Vector3d;
 
   // copy relevant info from zdock file
   if (zdock_.iszdock()) {
     receptor_ = zdock_.receptor();
     ligand_ = zdock_.ligand();
-    rev_ = zdock_.isswitched();
-    fixed_ = zdock_.isfixed();
     spacing_ = zdock_.spacing();
     boxsize_ = zdock_.boxsize();
     isvalid_ = true;
+    if (zdock_.isswitched()) {
+      mode_ = LigandMode::SWITCHED;
+    } else if (zdock_.isfixed()) {
+      mode_ = LigandMode::FIXED;
+    } else {
+      mode_ = LigandMode::UNFIXED;
+    }
 
-    // precalculate some transformation matrices
-    t0_ = Translation3d(-Vector3d(ligand_.translation)) *
-          u::eulerRotation(receptor_.rotation);
-    t1_ = Translation3d(Vector3d(receptor_.translation)) *
-          u::eulerRotation(ligand_.rotation, true);
-    t2_ = u::eulerRotation(ligand_.rotation) *
-          Translation3d(-Vector3d(ligand_.translation));
+    // precalculate constant factors
+    if (LigandMode::SWITCHED == mode_) {
+      f_.a = u::eulerRotation(ligand_.rotation, true).linear();
+      f_.c = u::eulerRotation(receptor_.rotation).linear();
+      f_.b = Vector3d(ligand_.translation);
+    } else {
+      f_.a = u::eulerRotation(ligand_.rotation).linear();
+      f_.c = u::eulerRotation(receptor_.rotation, true).linear();
+      f_.b = f_.a * Vector3d(ligand_.translation);
+    }
+    f_.t = Vector3d(receptor_.translation);
+    rotations_ = RotationCache(zdock_.predictions());
   }
 }
 
+template <typename T>
+const TransformUtil::Transforms
+TransformLigandT<T>::transforms(const std::vector<Prediction> &predictions,
+                                const size_t begin, const size_t end) const {
+  assert(isvalid_); // did we successfully load zdock data?
+  assert(begin <= end && end <= predictions.size());
+
+  // one mode dispatch per range
+  TransformUtil::Transforms tx;
+  tx.reserve(end - begin);
+  switch (mode_) {
+  case LigandMode::FIXED:
+    poses_<LigandMode::FIXED>(predictions, begin, end, tx);
+    break;
+  case LigandMode::UNFIXED:
+    poses_<LigandMode::UNFIXED>(predictions, begin, end, tx);
+    break;
+  default:
+    poses_<LigandMode::SWITCHED>(predictions, begin, end, tx);
+  }
+  return tx;
+}
+
+template <typename T>
+void TransformLigandT<T>::txLigandBatch(
+    const Matrix &matrix, const std::vector<Prediction> &predictions,
+    const size_t begin, const size_t end, Eigen::Ref<Matrix> out,
+    const size_t nthreads) const {
+  u::applyBatch<T>(matrix, transforms(predictions, begin, end), out,
+                   nthreads);
+}
+
+template <typename T>
+void TransformLigandT<T>::txLigandBatch(
+    const SoA<T> &in, const std::vector<Prediction> &predictions,
+    const size_t begin, const size_t end, SoA<T> &out,
+    const size_t nthreads) const {
+  u::applyBatch<T>(in, transforms(predictions, begin, end), out, nthreads);
+}
+
+// explicit instantiations; double and single precision coordinates
+template class TransformLigandT<double>;
+template class TransformLigandT<float>;
+
 } // namespace zdock
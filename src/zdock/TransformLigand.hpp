@@ -27,101 +27,209 @@
 #pragma once
 
 #include "PDB.hpp"
+#include "RotationCache.hpp"
 #include "TransformUtil.hpp"
 #include "ZDOCK.hpp"
 
 namespace zdock {
 
-class TransformLigand {
+//! ZDOCK transformation modes
+enum class LigandMode {
+  FIXED,   //!< ligand rotated, receptor fixed (-F)
+  UNFIXED, //!< ligand rotated, receptor randomly pre-rotated
+  SWITCHED //!< receptor and ligand switched; receptor was rotated
+};
+
+/**
+ * @brief Constant factors of the ligand transformation
+ *
+ * Everything that does not depend on the prediction, so that each
+ * prediction reduces to a rotation plus translation (see LigandKernel).
+ */
+struct LigandFactors {
+  Eigen::Matrix3d a; //!< rotation applied after the prediction rotation
+  Eigen::Matrix3d c; //!< rotation applied before the prediction rotation
+  Eigen::Vector3d b; //!< ligand translation (rotated for normal modes)
+  Eigen::Vector3d t; //!< receptor translation
+};
+
+/**
+ * @brief Per-mode prediction kernel; R and t from rotation Rp and grid
+ * offset d (in actual coordinate units)
+ */
+template <LigandMode M> struct LigandKernel;
+
+template <> struct LigandKernel<LigandMode::FIXED> {
+  /* X(rec trans) * X(-pred trans) * X(pred rot) *
+   *   X(lig rot) * X(-lig trans) * M
+   *
+   * R = Rp * Rl; t = rec_t - d - Rp * Rl * lig_t
+   */
+  template <typename X>
+  static inline void pose(const LigandFactors &f, const Eigen::Matrix3d &rp,
+                          const Eigen::Vector3d &d, X &x) {
+    x.linear().noalias() = rp * f.a;
+    x.translation() = f.t - d - rp * f.b;
+  }
+};
+
+template <> struct LigandKernel<LigandMode::UNFIXED> {
+  /* X(rec rot, reverse) * [fixed case]
+   *
+   * R = Rrec' * Rp * Rl; t = Rrec' * (rec_t - d - Rp * Rl * lig_t)
+   */
+  template <typename X>
+  static inline void pose(const LigandFactors &f, const Eigen::Matrix3d &rp,
+                          const Eigen::Vector3d &d, X &x) {
+    x.linear().noalias() = f.c * rp * f.a;
+    x.translation() = f.c * (f.t - d - rp * f.b);
+  }
+};
+
+template <> struct LigandKernel<LigandMode::SWITCHED> {
+  /* X(rec trans) * X(lig rot, reverse) *
+   *   X(pred rot, reverse) * X(pred trans) *
+   *     X(-lig trans) * X(rec rot) * M
+   *
+   * R = Rl' * Rp' * Rrec; t = rec_t + Rl' * Rp' * (d - lig_t)
+   */
+  template <typename X>
+  static inline void pose(const LigandFactors &f, const Eigen::Matrix3d &rp,
+                          const Eigen::Vector3d &d, X &x) {
+    const Eigen::Matrix3d q = f.a * rp.transpose();
+    x.linear().noalias() = q * f.c;
+    x.translation() = f.t + q * (d - f.b);
+  }
+};
+
+template <typename T> class TransformLigandT {
 
   /**
    * Performs ZDOCK prediction transformations on PDB structures.
+   *
+   * Transformations are composed in double precision and applied to
+   * coordinate matrices of scalar type T.
    */
 
 public:
-  TransformLigand(const std::string &zdock);
-  TransformLigand(const ZDOCK &zdock);
+  TransformLigandT(const std::string &zdock);
+  TransformLigandT(const ZDOCK &zdock);
+
+  //! coordinate matrix type
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Matrix;
 
 private:
   typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
-  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
   typedef TransformUtil u;
 
   zdock::Structure receptor_, ligand_; // zdock metadata
   ZDOCK zdock_;                        // zdock output
   double spacing_;                     // grid spacing
   int boxsize_;                        // grid size
-  bool rev_, fixed_;                   // fixed / switched flags
+  LigandMode mode_;                    // fixed / unfixed / switched
   bool isvalid_;                       // successfull init
 
-  // precomputed transformation matrices
-  Transform t0_, t1_, t2_;
+  // precomputed constant factors
+  LigandFactors f_;
+  RotationCache rotations_; // prediction rotations
+
+  // reduce prediction to rotation plus translation
+  template <LigandMode M>
+  inline const Transform pose_(const Prediction &pred) const {
+    Transform x;
+    LigandKernel<M>::pose(f_, rotations_.matrix(pred.rotation),
+                          spacing_ * u::boxedGridCoord(pred.translation,
+                                                       boxsize_),
+                          x);
+    return x;
+  }
 
-  // grid to actual translation ('circularized')
-  inline const Transform boxTranslation(const int (&t)[3],
-                                        bool rev = false) const {
-    Transform ret;
+  // compose transformations for a range of predictions
+  template <LigandMode M>
+  void poses_(const std::vector<Prediction> &predictions, const size_t begin,
+              const size_t end, TransformUtil::Transforms &tx) const {
+    for (size_t i = begin; i < end; ++i) {
+      tx.push_back(pose_<M>(predictions[i]));
+    }
+  }
 
-    using Eigen::Translation3d;
-    using Eigen::Vector3d;
+public:
+  /**
+   * @brief Compose the transformation for a single prediction
+   *
+   * @param pred ZDOCK prediction
+   * @return transformation taking input ligand coordinates to the pose
+   */
+  inline const Transform transform(const Prediction &pred) const {
+    assert(isvalid_); // did we successfully load zdock data?
 
-    Vector3d d = u::boxedGridCoord(t, boxsize_);
-    if (rev) {
-      ret = Translation3d(-spacing_ * d);
-    } else {
-      ret = Translation3d(spacing_ * d);
+    switch (mode_) {
+    case LigandMode::FIXED:
+      return pose_<LigandMode::FIXED>(pred);
+    case LigandMode::UNFIXED:
+      return pose_<LigandMode::UNFIXED>(pred);
+    default:
+      return pose_<LigandMode::SWITCHED>(pred);
     }
-    return ret;
   }
 
-public:
+  /**
+   * @brief Compose the transformations for a range of predictions
+   *
+   * @param predictions ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @return one transformation per prediction
+   */
+  const TransformUtil::Transforms
+  transforms(const std::vector<Prediction> &predictions, const size_t begin,
+             const size_t end) const;
+
   // perform actual ligand transformation
   inline const Matrix txLigand(const Matrix &matrix,
                                const Prediction &pred) const {
-    Transform t;
-
-    using Eigen::Translation3d;
-    using Eigen::Vector3d;
+    return u::apply<T>(transform(pred), matrix);
+  }
 
-    assert(isvalid_); // did we successfully load zdock data?
+  /**
+   * @brief Transform a matrix for a range of predictions
+   *
+   * Pose k (relative to begin) is written to columns [k * N, (k + 1) * N)
+   * of out, where N is the number of columns in matrix.
+   *
+   * @param matrix ligand coordinates
+   * @param predictions ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @param out contiguous pose buffer, 3 x (N * (end - begin))
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  void txLigandBatch(const Matrix &matrix,
+                     const std::vector<Prediction> &predictions,
+                     const size_t begin, const size_t end,
+                     Eigen::Ref<Matrix> out, const size_t nthreads = 0) const;
 
-    if (rev_) {
-
-      /* Transformation; reverse (receptor was rotated, rather than ligand)
-       *
-       *     X(rec trans) * X(lig rot, reverse) *
-       *       X(pred rot, reverse) * X(pred trans) *
-       *         X(-lig trans) * X(rec rot) * M
-       *
-       */
-
-      t = u::eulerRotation(pred.rotation, true) *
-          boxTranslation(pred.translation);
-      return t1_ * t * t0_ * matrix;
-    } else {
-
-      /* Transformation; normal (ligand was rotated)
-       *
-       * fixed case:
-       *     X(rec trans) * X(-pred trans) * X(pred rot) *
-       *       X(lig rot) * X(-lig trans) * M
-       *
-       * not fixed case:
-       *     X(rec rot, reverse) * [fixed case]
-       *
-       */
-
-      t = Translation3d(Vector3d(receptor_.translation)) *
-          boxTranslation(pred.translation, true) *
-          u::eulerRotation(pred.rotation) * t2_;
-      if (!fixed_) {
-        // !fixed means initial random rotation of receptor
-        // so we need to rotate to rec frame
-        t = u::eulerRotation(receptor_.rotation, true) * t;
-      }
-      return t * matrix;
-    }
-  }
+  /**
+   * @brief Transform SoA coordinates for a range of predictions
+   *
+   * Pose k (relative to begin) is written to structure k of out.
+   *
+   * @param in ligand coordinates (structure 0)
+   * @param predictions ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @param out pose buffer, at least end - begin structures
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  void txLigandBatch(const SoA<T> &in,
+                     const std::vector<Prediction> &predictions,
+                     const size_t begin, const size_t end, SoA<T> &out,
+                     const size_t nthreads = 0) const;
 };
 
+//! ligand transformations on double precision coordinates
+typedef TransformLigandT<double> TransformLigand;
+//! ligand transformations on single precision coordinates
+typedef TransformLigandT<float> TransformLigandf;
+
 } // namespace zdock
@@ -31,10 +31,12 @@ namespace p = libpdb;
 
 namespace zdock {
 
-TransformMultimer::TransformMultimer(const std::string &zdock)
-    : TransformMultimer(ZDOCK(zdock)) {}
+template <typename T>
+TransformMultimerT<T>::TransformMultimerT(const std::string &zdock)
+    : TransformMultimerT(ZDOCK(zdock)) {}
 
-TransformMultimer::TransformMultimer(const ZDOCK &zdock) : zdock_(zdock) {
+template <typename T>
+TransformMultimerT<T>::TransformMultimerT(const ZDOCK &zdock) : zdock_(zdock) {
 
   using e::Translation3d;
   using e::Vector3d;
@@ -54,14 +56,55 @@ TransformMultimer::TransformMultimer(const ZDOCK &zdock) : zdock_(zdock) {
     // precalculate some transformation matrices
     t0_ = TransformUtil::eulerRotation(structure_.rotation, true) *
           Translation3d(-Vector3d(structure_.translation));
+    for (int i = 0; i < symmetry_; ++i) {
+      mers_.push_back(u::eulerRotation({0.0, 0.0, beta_ * i}, true));
+    }
+    rotations_ = RotationCache(zdock_.predictions());
   }
 }
 
+template <typename T>
+const TransformUtil::Transforms
+TransformMultimerT<T>::transforms(const std::vector<Prediction> &predictions,
+                                  const size_t begin, const size_t end,
+                                  const int n) const {
+  assert(begin <= end && end <= predictions.size());
+
+  TransformUtil::Transforms tx;
+  tx.reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    tx.push_back(transform(predictions[i], n));
+  }
+  return tx;
+}
+
+template <typename T>
+void TransformMultimerT<T>::txMultimerBatch(
+    const Matrix &matrix, const std::vector<Prediction> &predictions,
+    const size_t begin, const size_t end, const int n, Eigen::Ref<Matrix> out,
+    const size_t nthreads) const {
+  u::applyBatch<T>(matrix, transforms(predictions, begin, end, n), out,
+                   nthreads);
+}
+
+template <typename T>
+void TransformMultimerT<T>::txMultimerBatch(
+    const SoA<T> &in, const std::vector<Prediction> &predictions,
+    const size_t begin, const size_t end, const int n, SoA<T> &out,
+    const size_t nthreads) const {
+  u::applyBatch<T>(in, transforms(predictions, begin, end, n), out,
+                   nthreads);
+}
+
 // alphabeth for chains
-const std::string TransformMultimer::CHAINS[52] = {
+template <typename T> const std::string TransformMultimerT<T>::CHAINS[52] = {
     "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M",
     "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z",
     "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m",
     "n", "o", "p", "q", "r", "s", "r", "u", "v", "w", "x", "y", "z"};
 
+// explicit instantiations; double and single precision coordinates
+template class TransformMultimerT<double>;
+template class TransformMultimerT<float>;
+
 } // namespace zdock
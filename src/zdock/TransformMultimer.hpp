@@ -27,12 +27,13 @@
 #pragma once
 
 #include "PDB.hpp"
+#include "RotationCache.hpp"
 #include "TransformUtil.hpp"
 #include "ZDOCK.hpp"
 
 namespace zdock {
 
-class TransformMultimer {
+template <typename T> class TransformMultimerT {
 
   /**
    * Implements M-ZDOCK prediction transformations on PDB structures.
@@ -45,15 +46,20 @@ class TransformMultimer {
    * Bioinformatics, Volume 21, Issue 8, 15 April 2005, Pages 1472–1478
    * https://doi.org/10.1093/bioinformatics/bti229
    *
+   * Transformations are composed in double precision and applied to
+   * coordinate matrices of scalar type T.
+   *
    */
 
 public:
-  TransformMultimer(const std::string &zdock);
-  TransformMultimer(const ZDOCK &zdock);
+  TransformMultimerT(const std::string &zdock);
+  TransformMultimerT(const ZDOCK &zdock);
+
+  //! coordinate matrix type
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Matrix;
 
 private:
   typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
-  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix;
   typedef TransformUtil u;
 
   zdock::Structure structure_; // zdock metadata
@@ -67,6 +73,8 @@ private:
 
   // precomputed transformation matrices
   Transform t0_;
+  TransformUtil::Transforms mers_; // rotation along z, one per mer
+  RotationCache rotations_;        // prediction rotations
 
   // grid to actual translation ('circularized')
   inline const Transform initialTranslation(const int (&t)[3],
@@ -86,13 +94,31 @@ private:
 public:
   static const std::string CHAINS[52];
 
-  // perform actual structure transformation
-  inline const Matrix txMultimer(const Matrix &matrix, const Prediction &pred,
-                                 int n) const {
-    Transform t;
-    using Eigen::Translation3d;
-    using Eigen::Vector3d;
+  /**
+   * @brief Get symmetry (number of mers)
+   *
+   * @return symmetry
+   */
+  int symmetry() const { return symmetry_; }
 
+  /**
+   * @brief Get the rotation about the symmetry (z) axis of a mer
+   *
+   * @param n which one of the n-mer
+   * @return rotation taking mer 0 to mer n
+   */
+  const Transform &mer(int n) const {
+    assert(n >= 0 && n < symmetry_);
+    return mers_[n];
+  }
+  /**
+   * @brief Compose the transformation for a single prediction
+   *
+   * @param pred M-ZDOCK prediction
+   * @param n which one of the n-mer
+   * @return transformation taking input coordinates to the pose
+   */
+  inline const Transform transform(const Prediction &pred, int n) const {
     assert(isvalid_); // did we successfully load m-zdock data?
     assert(n >= 0 && n < symmetry_);
 
@@ -109,11 +135,73 @@ public:
      *
      */
 
-    t = u::eulerRotation({0.0, 0.0, beta_ * n}, true) *
-        initialTranslation(pred.translation, alpha_) *
-        u::eulerRotation({pred.rotation[0], pred.rotation[1], 0.0}, true) * t0_;
-    return t * matrix;
+    return mers_[n] * initialTranslation(pred.translation, alpha_) *
+           rotations_.eulerRotation(
+               {pred.rotation[0], pred.rotation[1], 0.0}, true) *
+           t0_;
+  }
+
+  /**
+   * @brief Compose the transformations for a range of predictions
+   *
+   * @param predictions M-ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @param n which one of the n-mer
+   * @return one transformation per prediction
+   */
+  const TransformUtil::Transforms
+  transforms(const std::vector<Prediction> &predictions, const size_t begin,
+             const size_t end, const int n) const;
+
+  // perform actual structure transformation
+  inline const Matrix txMultimer(const Matrix &matrix, const Prediction &pred,
+                                 int n) const {
+    return u::apply<T>(transform(pred, n), matrix);
   }
+
+  /**
+   * @brief Transform a matrix for a range of predictions
+   *
+   * Pose k (relative to begin) is written to columns [k * N, (k + 1) * N)
+   * of out, where N is the number of columns in matrix.
+   *
+   * @param matrix structure coordinates
+   * @param predictions M-ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @param n which one of the n-mer
+   * @param out contiguous pose buffer, 3 x (N * (end - begin))
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  void txMultimerBatch(const Matrix &matrix,
+                       const std::vector<Prediction> &predictions,
+                       const size_t begin, const size_t end, const int n,
+                       Eigen::Ref<Matrix> out,
+                       const size_t nthreads = 0) const;
+
+  /**
+   * @brief Transform SoA coordinates for a range of predictions
+   *
+   * Pose k (relative to begin) is written to structure k of out.
+   *
+   * @param in structure coordinates (structure 0)
+   * @param predictions M-ZDOCK predictions
+   * @param begin first prediction
+   * @param end one past the last prediction
+   * @param n which one of the n-mer
+   * @param out pose buffer, at least end - begin structures
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  void txMultimerBatch(const SoA<T> &in,
+                       const std::vector<Prediction> &predictions,
+                       const size_t begin, const size_t end, const int n,
+                       SoA<T> &out, const size_t nthreads = 0) const;
 };
 
+//! M-ZDOCK transformations on double precision coordinates
+typedef TransformMultimerT<double> TransformMultimer;
+//! M-ZDOCK transformations on single precision coordinates
+typedef TransformMultimerT<float> TransformMultimerf;
+
 } // namespace zdock
@@ -25,11 +25,51 @@
  */
 
 #include "TransformUtil.hpp"
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 namespace zdock {
 
 // grab pi from Eigen
 const double TransformUtil::PI = EIGEN_PI;
+const Eigen::Index TransformUtil::BATCH_BLOCK;
+
+namespace {
+// exact (bitwise) rotation matrix
+struct RotationKey {
+  uint64_t r[9];
+  bool operator==(const RotationKey &o) const {
+    return std::equal(r, r + 9, o.r);
+  }
+};
+struct RotationKeyHash {
+  size_t operator()(const RotationKey &k) const {
+    uint64_t h = 0;
+    for (const auto x : k.r) {
+      h = h * 0x9e3779b97f4a7c15ULL ^ x;
+    }
+    return static_cast<size_t>(h ^ (h >> 29));
+  }
+};
+} // namespace
+
+std::vector<std::vector<size_t>>
+TransformUtil::groupByRotation(const Transforms &tx) {
+  std::vector<std::vector<size_t>> groups;
+  std::unordered_map<RotationKey, size_t, RotationKeyHash> index;
+  for (size_t i = 0; i < tx.size(); ++i) {
+    RotationKey key;
+    const Eigen::Matrix3d r = tx[i].linear();
+    std::memcpy(key.r, r.data(), sizeof(key.r));
+    const auto it = index.emplace(key, groups.size());
+    if (it.second) {
+      groups.emplace_back();
+    }
+    groups[it.first->second].push_back(i);
+  }
+  return groups;
+}
 
 } // namespace zdock
 
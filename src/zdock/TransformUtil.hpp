@@ -26,8 +26,13 @@
 
 #pragma once
 
+#include "Parallel.hpp"
+#include "Simd.hpp"
 #include <Eigen/Dense>
+#include <Eigen/StdVector>
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace zdock {
 
@@ -39,6 +44,13 @@ private:
 public:
   static const double PI;
 
+  //! list of affine transforms, one per pose
+  typedef std::vector<Transform, Eigen::aligned_allocator<Transform>>
+      Transforms;
+
+  //! number of atoms processed per block in applyBatch
+  static const Eigen::Index BATCH_BLOCK = 512;
+
   // Euler angles to Z-X-Z transformation matrix
   static inline const Transform eulerRotation(const double (&r)[3],
                                               bool rev = false) {
@@ -63,6 +75,171 @@ public:
         (v[2] >= boxsize / 2 ? v[2] - boxsize : v[2]);
     return d;
   }
+
+  /**
+   * @brief Apply a transform in a single fused pass over the coordinates
+   *
+   * @param tx transform (composed in double precision)
+   * @param matrix coordinates to transform
+   * @return transformed coordinates
+   */
+  template <typename T>
+  static inline const Eigen::Matrix<T, 3, Eigen::Dynamic>
+  apply(const Transform &tx,
+        const Eigen::Matrix<T, 3, Eigen::Dynamic> &matrix) {
+    const Eigen::Matrix<T, 3, 3> r = tx.linear().template cast<T>();
+    const Eigen::Matrix<T, 3, 1> t = tx.translation().template cast<T>();
+    return r.lazyProduct(matrix).colwise() + t;
+  }
+
+  /**
+   * @brief Group transforms that share the same rotation
+   *
+   * @param tx transforms
+   * @return groups of indices into tx, in order of first occurrence
+   */
+  static std::vector<std::vector<size_t>>
+  groupByRotation(const Transforms &tx);
+
+  /**
+   * @brief Apply many transforms to a single coordinate matrix
+   *
+   * Pose k is written to columns [k * N, (k + 1) * N) of out, where N is
+   * the number of columns in matrix. Transforms sharing a rotation are
+   * grouped, so the coordinates are rotated once per distinct rotation and
+   * each pose only adds its translation. Atoms are processed in blocks of
+   * BATCH_BLOCK so that each block stays in cache while all transforms
+   * are applied to it. Poses, ordered by rotation group, are divided over
+   * threads, so a single large group still uses all threads.
+   *
+   * @param matrix coordinates to transform
+   * @param tx transforms (composed in double precision)
+   * @param out contiguous pose buffer, 3 x (N * tx.size())
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  template <typename T>
+  static void
+  applyBatch(const Eigen::Matrix<T, 3, Eigen::Dynamic> &matrix,
+             const Transforms &tx,
+             Eigen::Ref<Eigen::Matrix<T, 3, Eigen::Dynamic>> out,
+             const size_t nthreads = 0) {
+    const Eigen::Index n = matrix.cols();
+    assert(out.cols() == n * static_cast<Eigen::Index>(tx.size()));
+
+    const GroupedPoses_ groups(tx);
+    Parallel::forRange(tx.size(), nthreads, [&](size_t begin, size_t end) {
+      // rotations in target precision, one per group in this range
+      const auto runs = groups.runs(begin, end);
+      std::vector<Eigen::Matrix<T, 3, 3>> r;
+      r.reserve(runs.size());
+      for (const auto &run : runs) {
+        r.push_back(tx[groups.members[run.first]].linear().template cast<T>());
+      }
+      Eigen::Matrix<T, 3, Eigen::Dynamic> rotated(3,
+                                                  std::min(BATCH_BLOCK, n));
+      for (Eigen::Index b = 0; b < n; b += BATCH_BLOCK) {
+        const Eigen::Index len = std::min(BATCH_BLOCK, n - b);
+        const auto block = matrix.middleCols(b, len);
+        for (size_t i = 0; i < runs.size(); ++i) {
+          if (runs[i].single) {
+            // single pose; fused rotation and translation
+            const size_t k = groups.members[runs[i].first];
+            const Eigen::Index col = static_cast<Eigen::Index>(k) * n + b;
+            out.middleCols(col, len).noalias() =
+                r[i].lazyProduct(block).colwise() +
+                tx[k].translation().template cast<T>();
+            continue;
+          }
+          // rotate once, translate many
+          rotated.leftCols(len).noalias() = r[i].lazyProduct(block);
+          for (size_t m = runs[i].first; m < runs[i].last; ++m) {
+            const size_t k = groups.members[m];
+            const Eigen::Index col = static_cast<Eigen::Index>(k) * n + b;
+            out.middleCols(col, len) = rotated.leftCols(len).colwise() +
+                                       tx[k].translation().template cast<T>();
+          }
+        }
+      }
+    });
+  }
+
+  /**
+   * @brief Apply many transforms to a single SoA structure
+   *
+   * Pose k is written to structure k of out. As for the matrix version,
+   * coordinates are rotated once per distinct rotation (and range of
+   * poses), and poses are divided over threads; the SIMD kernel is
+   * selected at runtime (see Simd).
+   *
+   * @param in coordinates to transform (structure 0)
+   * @param tx transforms (composed in double precision)
+   * @param out pose buffer, at least tx.size() structures
+   * @param nthreads number of threads (0 for all hardware threads)
+   */
+  template <typename T>
+  static void applyBatch(const SoA<T> &in, const Transforms &tx, SoA<T> &out,
+                         const size_t nthreads = 0) {
+    assert(in.natoms() == out.natoms() && out.count() >= tx.size());
+
+    const GroupedPoses_ groups(tx);
+    const auto &kernels = Simd::kernels<T>();
+    const size_t n = in.natoms();
+    Parallel::forRange(tx.size(), nthreads, [&](size_t begin, size_t end) {
+      SoA<T> rotated(n, 1);
+      T m[12];
+      for (const auto &run : groups.runs(begin, end)) {
+        if (run.single) {
+          const size_t k = groups.members[run.first];
+          Simd::apply(tx[k], in, 0, out, k);
+          continue;
+        }
+        // rotate once, translate many
+        Simd::pack(tx[groups.members[run.first]], m);
+        m[9] = m[10] = m[11] = T(0);
+        kernels.apply(m, in.x(), in.y(), in.z(), n, rotated.x(), rotated.y(),
+                      rotated.z());
+        for (size_t i = run.first; i < run.last; ++i) {
+          const size_t k = groups.members[i];
+          Simd::pack(tx[k], m);
+          kernels.translate(m + 9, rotated.x(), rotated.y(), rotated.z(), n,
+                            out.x(k), out.y(k), out.z(k));
+        }
+      }
+    });
+  }
+
+private:
+  // poses ordered by rotation group (see groupByRotation), so that
+  // contiguous ranges of poses can be divided over threads
+  struct GroupedPoses_ {
+    // part of a group within a range of poses
+    struct Run {
+      size_t first, last; // positions in members
+      bool single;        // the group has a single pose
+    };
+    std::vector<size_t> members; // poses of all groups, in group order
+    std::vector<size_t> offsets; // start of each group in members, and end
+
+    explicit GroupedPoses_(const Transforms &tx) {
+      offsets.push_back(0);
+      for (const auto &g : groupByRotation(tx)) {
+        members.insert(members.end(), g.begin(), g.end());
+        offsets.push_back(members.size());
+      }
+    }
+    // groups overlapping positions [begin, end), clipped to the range
+    std::vector<Run> runs(const size_t begin, const size_t end) const {
+      std::vector<Run> ret;
+      size_t g = std::upper_bound(offsets.begin(), offsets.end(), begin) -
+                 offsets.begin() - 1;
+      for (; g + 1 < offsets.size() && offsets[g] < end; ++g) {
+        ret.push_back({std::max(begin, offsets[g]),
+                       std::min(end, offsets[g + 1]),
+                       1 == offsets[g + 1] - offsets[g]});
+      }
+      return ret;
+    }
+  };
 };
 
 } // namespace zdock
@@ -34,56 +34,87 @@ namespace zdock {
 
 ZDOCK::ZDOCK(const std::string &fn)
     : boxsize_(0), spacing_(0.0), isswitched_(false), ismzdock_(false),
-      isfixed_(false), version_(0), symmetry_(0), filename_(fn) {
+      isfixed_(false), version_(0), symmetry_(0), filename_(fn), linenum_(0),
+      hasformat_(false) {
   read_();
 }
 
+ZDOCK::ZDOCK(std::istream &in, const std::string &fn)
+    : boxsize_(0), spacing_(0.0), isswitched_(false), ismzdock_(false),
+      isfixed_(false), version_(0), symmetry_(0), filename_(fn), linenum_(0),
+      hasformat_(false) {
+  read_(in, true);
+}
+
+bool ZDOCK::parse_(const std::string &line, Prediction &p) {
+  p.ismzdock = false;
+  if (7 == std::sscanf(line.c_str(), "%lf\t%lf\t%lf\t%d\t%d\t%d\t%lf",
+                       &p.rotation[0], &p.rotation[1], &p.rotation[2],
+                       &p.translation[0], &p.translation[1], &p.translation[2],
+                       &p.score)) {
+    if (hasformat_ && ismzdock_) {
+      // M-ZDOCK established but 7-column prediction encountered
+      throw ZDOCKInvalidFormat(filename_,
+                               "Invalid M-ZDOCK prediction (line " +
+                                   std::to_string(linenum_) + ")");
+    }
+    hasformat_ = true;
+    return true;
+  } else if (5 == std::sscanf(line.c_str(), "%lf\t%lf\t%d\t%d\t%lf",
+                              &p.rotation[0], &p.rotation[1],
+                              &p.translation[0], &p.translation[1],
+                              &p.score)) {
+    if (hasformat_ && !ismzdock_) {
+      // ZDOCK established but 5-column prediction encountered
+      throw ZDOCKInvalidFormat(filename_, "Invalid ZDOCK prediction (line " +
+                                              std::to_string(linenum_) + ")");
+    }
+    p.rotation[2] = 0.0;
+    p.translation[2] = 0.0;
+    ismzdock_ = true;
+    hasformat_ = true;
+    p.ismzdock = true;
+    return true;
+  }
+  return false;
+}
+
+bool ZDOCK::next(std::istream &in, Prediction &p) {
+  std::string line;
+  if (!std::getline(in, line)) {
+    return false;
+  }
+  linenum_++;
+  if (!parse_(line, p)) {
+    throw ZDOCKInvalidFormat(filename_, "Invalid prediction (line " +
+                                            std::to_string(linenum_) + ")");
+  }
+  return true;
+}
+
 void ZDOCK::read_() {
-  std::vector<std::string> header;
   std::ifstream infile(filename_);
+  read_(infile, false); // header error below if file could not be read
+}
+
+void ZDOCK::read_(std::istream &in, const bool stream) {
+  std::vector<std::string> header;
   std::string line;
-  if (infile.is_open()) {
-    predictions_.clear();
-    bool headerdone = false;
-    int linenum = 1;
-    while (std::getline(infile, line)) {
-      Prediction p;
-      p.ismzdock = false;
-      if (7 == std::sscanf(line.c_str(), "%lf\t%lf\t%lf\t%d\t%d\t%d\t%lf",
-                           &p.rotation[0], &p.rotation[1], &p.rotation[2],
-                           &p.translation[0], &p.translation[1],
-                           &p.translation[2], &p.score)) {
-        if (ismzdock_) {
-          // M-ZDOCK established but 7-column prediction encountered
-          throw ZDOCKInvalidFormat(filename_,
-                                   "Invalid M-ZDOCK prediction (line " +
-                                       std::to_string(linenum) + ")");
-        }
-        headerdone = true;
-        predictions_.push_back(p);
-      } else if (5 == std::sscanf(line.c_str(), "%lf\t%lf\t%d\t%d\t%lf",
-                                  &p.rotation[0], &p.rotation[1],
-                                  &p.translation[0], &p.translation[1],
-                                  &p.score)) {
-        if (!ismzdock_ && predictions_.size() > 0) {
-          // ZDOCK established but 5-column prediction encountered
-          throw ZDOCKInvalidFormat(filename_,
-                                   "Invalid ZDOCK prediction (line " +
-                                       std::to_string(linenum) + ")");
-        }
-        p.rotation[2] = 0.0;
-        p.translation[2] = 0.0;
-        ismzdock_ = true;
-        p.ismzdock = true;
-        headerdone = true;
-        predictions_.push_back(p);
-      } else if (!headerdone) {
-        header.push_back(line);
-      } else {
-        throw ZDOCKInvalidFormat(filename_, "Invalid prediction (line " +
-                                                std::to_string(linenum) + ")");
-      }
-      linenum++;
+  predictions_.clear();
+  linenum_ = 0;
+  hasformat_ = false;
+  bool headerdone = false;
+  while ((!stream || !headerdone) && std::getline(in, line)) {
+    Prediction p;
+    linenum_++;
+    if (parse_(line, p)) {
+      headerdone = true;
+      predictions_.push_back(p);
+    } else if (!headerdone) {
+      header.push_back(line);
+    } else {
+      throw ZDOCKInvalidFormat(filename_, "Invalid prediction (line " +
+                                              std::to_string(linenum_) + ")");
     }
   }
 
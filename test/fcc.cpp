@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FCC.hpp"
+#include "PDB.hpp"
+#include "TransformLigand.hpp"
+#include "ZDOCK.hpp"
+#include "Test.hpp"
+
+#include <algorithm>
+#include <string>
+
+TEST_CASE("Fraction of common contacts", "[fcc]") {
+  const zdock::ZDOCK z(test::getpath("2OOB/zdock.out.pruned"));
+  const zdock::PDB lig(test::getpath("2OOB/ligand.pdb"),
+                       zdock::Selection("not hydrogen"));
+  const zdock::PDB &rec = lig; // ligand doubles as receptor
+  const zdock::TransformLigand txl(z);
+  const auto &preds = z.predictions();
+  const auto tx = txl.transforms(preds, 0, preds.size());
+  const zdock::FCC fcc(rec, lig);
+
+  SECTION("Contacts match brute force") {
+    const auto &rres = rec.residues();
+    const auto &lres = lig.residues();
+    for (size_t i = 0; i < preds.size(); i += 29) {
+      const zdock::PDB::Matrix pose = tx[i] * lig.matrix();
+      std::vector<uint32_t> brute;
+      for (size_t r = 0; r < rres.size(); ++r) {
+        for (size_t l = 0; l < lres.size(); ++l) {
+          bool contact = false;
+          for (size_t a = rres[r].begin; a < rres[r].end && !contact; ++a) {
+            for (size_t b = lres[l].begin; b < lres[l].end && !contact; ++b) {
+              contact = (rec.matrix().col(a) - pose.col(b)).norm() <= 5.0;
+            }
+          }
+          if (contact) {
+            brute.push_back(r * lres.size() + l);
+          }
+        }
+      }
+      REQUIRE(brute == fcc.contacts(tx[i]));
+    }
+  }
+
+  SECTION("Fingerprint similarity") {
+    const auto fp = fcc.fingerprints(tx, 2);
+    REQUIRE(preds.size() == fp.size());
+    for (size_t i = 0; i < preds.size(); i += 17) {
+      const auto ci = fcc.contacts(tx[i]);
+      REQUIRE(ci.size() == fp.count(i));
+      if (fp.count(i)) {
+        REQUIRE(1.0 == fp.similarity(i, i));
+      }
+      for (size_t j = 0; j < preds.size(); j += 13) {
+        const auto cj = fcc.contacts(tx[j]);
+        std::vector<uint32_t> common;
+        std::set_intersection(ci.begin(), ci.end(), cj.begin(), cj.end(),
+                              std::back_inserter(common));
+        REQUIRE(common.size() == fp.common(i, j));
+        REQUIRE(fp.similarity(i, j) == fp.similarity(j, i));
+        const size_t m = std::max(ci.size(), cj.size());
+        REQUIRE(fp.similarity(i, j) ==
+                (m ? static_cast<double>(common.size()) / m : 0.0));
+      }
+    }
+  }
+}
@@ -0,0 +1,82 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PDB.hpp"
+#include "Test.hpp"
+
+#include <string>
+
+TEST_CASE("Chain and residue index", "[hierarchy]") {
+  const std::string _ligand = "2OOB/ligand.pdb";
+
+  REQUIRE_NOTHROW(test::getpath(_ligand));
+  zdock::PDB p(test::getpath(_ligand));
+
+  SECTION("Chains") {
+    REQUIRE(1 == p.chains().size());
+    REQUIRE('b' == p.chains()[0].chain);
+    REQUIRE(0 == p.chains()[0].begin);
+    REQUIRE(p.residues().size() == p.chains()[0].end);
+  }
+
+  SECTION("Residues") {
+    const double epsilon = 1e-12;
+    REQUIRE(72 == p.residues().size());
+    REQUIRE(1 == p.residues().front().seqNum);
+    REQUIRE(p.atoms().size() == p.residues().back().end);
+    size_t next = 0;
+    for (const auto &r : p.residues()) {
+      REQUIRE(next == r.begin);
+      REQUIRE(r.end > r.begin);
+      for (size_t i = r.begin; i < r.end; ++i) {
+        REQUIRE(r.seqNum == p.atoms()[i]->atom.residue.seqNum);
+        REQUIRE((p.matrix().col(i) - r.centroid).norm() <= r.radius + epsilon);
+      }
+      REQUIRE((p.matrix().middleCols(r.begin, r.size()).rowwise().mean() -
+               r.centroid)
+                  .squaredNorm() < epsilon);
+      next = r.end;
+    }
+  }
+
+  SECTION("Residues of a selection") {
+    zdock::PDB ca(test::getpath(_ligand), zdock::Selection("name CA"));
+    REQUIRE(72 == ca.residues().size());
+    for (const auto &r : ca.residues()) {
+      REQUIRE(1 == r.size());
+      REQUIRE(0.0 == r.radius);
+    }
+  }
+
+  SECTION("Centroids follow setMatrix") {
+    zdock::PDB::Matrix m = p.matrix();
+    m.colwise() += Eigen::Vector3d(1.0, 2.0, 3.0);
+    const Eigen::Vector3d c = p.residues()[5].centroid;
+    p.setMatrix(m);
+    REQUIRE((p.residues()[5].centroid - c - Eigen::Vector3d(1.0, 2.0, 3.0))
+                .squaredNorm() < 1e-12);
+  }
+}
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Metrics.hpp"
+#include "Exception.hpp"
+#include "Test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// lines of a file
+static std::vector<std::string> lines(const std::string &fn) {
+  std::ifstream in(fn);
+  std::vector<std::string> ret;
+  std::string line;
+  while (std::getline(in, line)) {
+    ret.push_back(line);
+  }
+  return ret;
+}
+
+TEST_CASE("Progress metrics", "[metrics]") {
+  const std::string fn = "/tmp/tmpMtR3xz";
+  zdock::Metrics metrics;
+
+  SECTION("Disabled") {
+    REQUIRE(!metrics.enabled());
+    metrics.stage("cluster", 10);
+    metrics.progress(5);
+    metrics.end(10);
+  }
+
+  SECTION("Records") {
+    metrics.open(fn, 0.0); // no rate limit
+    REQUIRE(metrics.enabled());
+    metrics.stage("cluster", 10);
+    metrics.progress(5, 42);
+    metrics.end(10, 84);
+    metrics.close();
+    REQUIRE(!metrics.enabled());
+    const auto l = lines(fn);
+    REQUIRE(3 == l.size());
+    REQUIRE(std::string::npos != l[0].find("\"event\": \"start\""));
+    REQUIRE(std::string::npos != l[1].find("\"event\": \"progress\""));
+    REQUIRE(std::string::npos != l[2].find("\"event\": \"end\""));
+    for (const auto &x : l) {
+      REQUIRE('{' == x.front());
+      REQUIRE('}' == x.back());
+      REQUIRE(std::string::npos != x.find("\"stage\": \"cluster\""));
+      REQUIRE(std::string::npos != x.find("\"total\": 10,"));
+      REQUIRE(std::string::npos != x.find("\"rate\": "));
+      REQUIRE(std::string::npos != x.find("\"eta\": "));
+      REQUIRE(std::string::npos != x.find("\"peak_rss_kb\": "));
+    }
+    REQUIRE(std::string::npos != l[1].find("\"items\": 5,"));
+    REQUIRE(std::string::npos != l[1].find("\"pairs\": 42,"));
+    REQUIRE(std::string::npos != l[2].find("\"items\": 10,"));
+    REQUIRE(std::string::npos != l[2].find("\"eta\": 0.0,"));
+  }
+
+  SECTION("Rate limit") {
+    metrics.open(fn, 3600.0);
+    metrics.stage("filter");
+    for (size_t i = 0; i < 1000; ++i) {
+      metrics.progress(i);
+    }
+    metrics.end(1000);
+    metrics.close();
+    const auto l = lines(fn);
+    REQUIRE(2 == l.size());
+    REQUIRE(std::string::npos != l[0].find("\"eta\": null"));
+  }
+
+  SECTION("Invalid target") {
+    REQUIRE_THROWS_AS(metrics.open("/nonexistent/metrics"),
+                      zdock::MetricsException);
+    REQUIRE_THROWS_AS(metrics.open("987"), zdock::MetricsException);
+    REQUIRE(!metrics.enabled());
+  }
+  std::remove(fn.c_str());
+}
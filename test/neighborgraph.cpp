@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "NeighborGraph.hpp"
+#include "PDB.hpp"
+#include "PoseRMSD.hpp"
+#include "TransformLigand.hpp"
+#include "ZDOCK.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+TEST_CASE("Neighbor graph", "[neighborgraph]") {
+  const zdock::PDB lig(test::getpath("2OOB/ligand.pdb"),
+                       zdock::Selection("name CA"));
+  const zdock::ZDOCK z(test::getpath("2OOB/zdock.out.pruned"));
+  const auto &preds = z.predictions();
+  const size_t n = preds.size();
+  const zdock::PoseRMSD moments(lig.matrix());
+  const auto emb =
+      moments.embed(zdock::TransformLigand(z).transforms(preds, 0, n));
+  auto rmsd = [&emb](const size_t i, const size_t j) {
+    return std::sqrt(zdock::PoseRMSD::rmsd2(emb[i], emb[j]));
+  };
+
+  // all pairs within the maximum cutoff
+  const double maxcutoff = 16.0;
+  const uint64_t key = zdock::NeighborGraph::key(preds, "name CA");
+  zdock::NeighborGraph graph(n, maxcutoff, key);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      if (rmsd(i, j) < maxcutoff) {
+        graph.add(j, rmsd(i, j));
+      }
+    }
+    graph.next();
+  }
+  REQUIRE(n == graph.nrows());
+  REQUIRE(graph.nedges() > 0);
+  REQUIRE_THROWS_AS(graph.next(), zdock::NeighborGraphException);
+
+  SECTION("Greedy clusters at smaller cutoffs") {
+    for (const double cutoff : {4.0, 8.0, 12.0, 16.0}) {
+      // brute force greedy
+      std::vector<int> expected(n, 0);
+      int clusters = 0;
+      for (size_t i = 0; i < n; ++i) {
+        if (!expected[i]) {
+          expected[i] = ++clusters;
+          for (size_t j = i + 1; j < n; ++j) {
+            if (!expected[j] && rmsd(i, j) < cutoff) {
+              expected[j] = clusters;
+            }
+          }
+        }
+      }
+      REQUIRE(expected == graph.cluster(cutoff));
+    }
+    REQUIRE_THROWS_AS(graph.cluster(20.0), zdock::NeighborGraphException);
+  }
+
+  SECTION("Save and load") {
+    const std::string fn = "/tmp/tmpNgR7kq";
+    graph.save(fn);
+    const zdock::NeighborGraph other = zdock::NeighborGraph::load(fn);
+    // truncated files and impossible pair counts are rejected before any
+    // allocation
+    std::string bytes;
+    {
+      std::ifstream in(fn, std::ios::binary);
+      bytes.assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+    }
+    auto corrupt = [&fn](const std::string &b) {
+      std::ofstream(fn, std::ios::binary) << b;
+      REQUIRE_THROWS_AS(zdock::NeighborGraph::load(fn),
+                        zdock::NeighborGraphException);
+    };
+    corrupt(bytes.substr(0, bytes.size() - 8));
+    std::string huge = bytes;
+    const uint64_t nedges = uint64_t(1) << 60;
+    huge.replace(36, sizeof(nedges), reinterpret_cast<const char *>(&nedges),
+                 sizeof(nedges));
+    corrupt(huge);
+    std::remove(fn.c_str());
+    REQUIRE(n == other.size());
+    REQUIRE(maxcutoff == other.cutoff());
+    REQUIRE(key == other.key());
+    REQUIRE(graph.nedges() == other.nedges());
+    for (size_t i = 0; i < n; ++i) {
+      REQUIRE(graph.degree(i) == other.degree(i));
+      for (size_t k = 0; k < graph.degree(i); ++k) {
+        REQUIRE(graph.neighbors(i)[k] == other.neighbors(i)[k]);
+        REQUIRE(graph.distances(i)[k] == other.distances(i)[k]);
+      }
+    }
+    REQUIRE(graph.cluster(8.0) == other.cluster(8.0));
+    REQUIRE_THROWS_AS(
+        zdock::NeighborGraph::load(test::getpath("2OOB/zdock.out.pruned")),
+        zdock::NeighborGraphException);
+  }
+
+  SECTION("Key") {
+    REQUIRE(key != zdock::NeighborGraph::key(preds, "name N"));
+    auto other = preds;
+    other.back().translation[0]++;
+    REQUIRE(key != zdock::NeighborGraph::key(other, "name CA"));
+  }
+}
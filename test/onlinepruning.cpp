@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "OnlinePruning.hpp"
+#include "PDB.hpp"
+#include "PoseRMSD.hpp"
+#include "TransformLigand.hpp"
+#include "TransformMultimer.hpp"
+#include "Exception.hpp"
+#include "ZDOCK.hpp"
+#include "Test.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// batch greedy clustering, by brute force, with the RMSD of prune():
+// moments of the single precision structure, all pairs compared
+static std::vector<int> greedy(const zdock::ZDOCK &z,
+                               const zdock::PDB::Matrix &structure,
+                               const double cutoff) {
+  const auto &preds = z.predictions();
+  const zdock::PoseRMSD moments(structure);
+  std::vector<zdock::PoseRMSD::Point> e0, e1;
+  if (z.ismzdock()) {
+    const zdock::TransformMultimer txm(z);
+    e0 = moments.embed(txm.transforms(preds, 0, preds.size(), 0));
+    e1 = moments.embed(txm.transforms(preds, 0, preds.size(), 2));
+  } else {
+    e0 = moments.embed(zdock::TransformLigand(z).transforms(preds, 0,
+                                                             preds.size()));
+  }
+  std::vector<int> l(preds.size(), 0);
+  int clusters = 0;
+  for (size_t i = 0; i < preds.size(); ++i) {
+    if (!l[i]) {
+      l[i] = ++clusters;
+      for (size_t j = i + 1; j < preds.size(); ++j) {
+        double d = zdock::PoseRMSD::rmsd2(e0[i], e0[j]);
+        if (z.ismzdock()) {
+          d = std::min(d, zdock::PoseRMSD::rmsd2(e0[i], e1[j]));
+        }
+        if (!l[j] && std::sqrt(d) < cutoff) {
+          l[j] = clusters;
+        }
+      }
+    }
+  }
+  return l;
+}
+
+TEST_CASE("Online pruning", "[onlinepruning]") {
+  const zdock::PDBf ligf(test::getpath("2OOB/ligand.pdb"),
+                         zdock::Selection("name CA"));
+  const zdock::PDB::Matrix structure = ligf.matrix().cast<double>();
+  for (const std::string fn :
+       {"2OOB/zdock.out.pruned", "ZDOCK/2MTA.zd.out", "ZDOCK/mzdock.out"}) {
+    const zdock::ZDOCK batch(test::getpath(fn));
+    for (const double cutoff : {4.0, 10.0}) {
+      const auto expected = greedy(batch, structure, cutoff);
+
+      // stream the file
+      std::ifstream in(test::getpath(fn));
+      zdock::ZDOCK z(in, test::getpath(fn));
+      REQUIRE(1 == z.npredictions());
+      REQUIRE(z.ismzdock() == batch.ismzdock());
+      zdock::OnlinePruning online(z, structure, cutoff);
+      zdock::Prediction p = z.predictions()[0];
+      size_t i = 0;
+      int clusters = 0;
+      do {
+        const auto a = online.add(p);
+        REQUIRE(expected[i] == a.cluster);
+        REQUIRE(a.representative == (a.cluster > clusters));
+        clusters = std::max(clusters, a.cluster);
+        REQUIRE(batch.predictions()[i].score == p.score);
+        i++;
+      } while (z.next(in, p));
+      REQUIRE(batch.npredictions() == i);
+      REQUIRE(online.size() == i);
+      REQUIRE(static_cast<size_t>(clusters) == online.nclusters());
+    }
+  }
+}
+
+TEST_CASE("Streamed input format", "[onlinepruning]") {
+  // a prediction in the other format after the first is rejected while
+  // streaming, as it is when the whole file is read
+  auto mixed = [](const std::string &fn, const std::string &line) {
+    const std::string tmp = "/tmp/tmpStMx3q";
+    {
+      std::ifstream in(test::getpath(fn));
+      std::ofstream out(tmp);
+      out << in.rdbuf() << line << std::endl;
+    }
+    REQUIRE_THROWS_AS(zdock::ZDOCK(tmp), zdock::ZDOCKInvalidFormat);
+    std::ifstream in(tmp);
+    zdock::ZDOCK z(in, tmp);
+    const bool ismzdock = z.ismzdock();
+    zdock::Prediction p;
+    size_t n = 1;
+    REQUIRE_THROWS_AS(
+        [&]() {
+          while (z.next(in, p)) {
+            n++;
+          }
+        }(),
+        zdock::ZDOCKInvalidFormat);
+    REQUIRE(zdock::ZDOCK(test::getpath(fn)).npredictions() == n);
+    REQUIRE(z.ismzdock() == ismzdock);
+    std::remove(tmp.c_str());
+  };
+  mixed("ZDOCK/4EEW.zd.out", "1.0\t2.0\t3\t4\t5.0");
+  mixed("ZDOCK/mzdock.out", "1.0\t2.0\t3.0\t4\t5\t6\t7.0");
+}
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Parallel.hpp"
+#include "Exception.hpp"
+#include "Test.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+TEST_CASE("Parallel loops", "[parallel]") {
+  const size_t n = 10007;
+
+  SECTION("forRange covers range once") {
+    std::vector<int> v(n, 0);
+    zdock::Parallel::forRange(n, 4, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; ++i) {
+        v[i]++;
+      }
+    });
+    REQUIRE(n == static_cast<size_t>(std::accumulate(v.begin(), v.end(), 0)));
+    REQUIRE(v.end() == std::find(v.begin(), v.end(), 0));
+  }
+
+  SECTION("ThreadPool repeated loops") {
+    zdock::ThreadPool pool(4);
+    REQUIRE(4 == pool.size());
+    std::vector<int> v(n, 0);
+    for (int k = 0; k < 100; ++k) {
+      pool.run(n - k, 64, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+          v[i]++;
+        }
+      });
+    }
+    for (size_t i = 0; i < n; ++i) {
+      REQUIRE(std::min<int>(100, n - i) == v[i]);
+    }
+  }
+
+  SECTION("ThreadPool exceptions") {
+    zdock::ThreadPool pool(3);
+    REQUIRE_THROWS_AS(pool.run(n, 16,
+                               [&](size_t b, size_t) {
+                                 if (b > n / 2) {
+                                   throw zdock::Exception("error");
+                                 }
+                               }),
+                      zdock::Exception);
+    // still usable
+    std::atomic<size_t> count(0);
+    pool.run(10, 1, [&](size_t, size_t) { ++count; });
+    REQUIRE(10 == count);
+  }
+}
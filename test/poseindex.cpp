@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Eigen/Dense"
+#include "PDB.hpp"
+#include "PoseIndex.hpp"
+#include "TransformLigand.hpp"
+#include "ZDOCK.hpp"
+#include "Test.hpp"
+
+#include <algorithm>
+#include <string>
+
+TEST_CASE("Pose index", "[poseindex]") {
+  const std::string zdockfn = test::getpath("2OOB/zdock.out.pruned");
+  const std::string ligandfn = test::getpath("2OOB/ligand.pdb");
+  const zdock::ZDOCK z(zdockfn);
+  const zdock::PDB lig(ligandfn, zdock::Selection("name CA"));
+  const zdock::TransformLigand txl(z);
+  const zdock::PoseIndex index(z, lig.matrix());
+  const auto &preds = z.predictions();
+
+  REQUIRE(preds.size() == index.size());
+
+  SECTION("Predictions find themselves") {
+    for (size_t i = 0; i < preds.size(); i += 7) {
+      const auto hits = index.nearest(txl.transform(preds[i]), 1);
+      REQUIRE(1 == hits.size());
+      REQUIRE(hits[0].rmsd < 1e-6);
+      REQUIRE(hits[0].rmsd ==
+              index.nearest(txl.transform(preds[hits[0].index]), 1)[0].rmsd);
+    }
+  }
+
+  SECTION("Matches brute force RMSD") {
+    // perturbed pose, not on the sampling grid
+    zdock::PoseIndex::Transform tx;
+    tx = Eigen::Translation3d(0.7, -0.4, 1.3) * txl.transform(preds[10]) *
+         Eigen::AngleAxisd(0.2, Eigen::Vector3d::UnitY());
+    const zdock::PDB::Matrix query = tx * lig.matrix();
+    std::vector<std::pair<double, size_t>> brute;
+    for (size_t i = 0; i < preds.size(); ++i) {
+      const double rmsd =
+          std::sqrt((txl.txLigand(lig.matrix(), preds[i]) - query)
+                        .colwise()
+                        .squaredNorm()
+                        .mean());
+      brute.push_back({rmsd, i});
+    }
+    std::sort(brute.begin(), brute.end());
+    const size_t k = 5;
+    const auto hits = index.nearest(tx, k);
+    REQUIRE(k == hits.size());
+    for (size_t i = 0; i < k; ++i) {
+      REQUIRE(brute[i].second == hits[i].index);
+      REQUIRE(std::abs(brute[i].first - hits[i].rmsd) < 1e-6);
+    }
+    // from coordinates (superposition)
+    const auto hits2 = index.nearest(query, k);
+    for (size_t i = 0; i < k; ++i) {
+      REQUIRE(hits[i].index == hits2[i].index);
+      REQUIRE(std::abs(hits[i].rmsd - hits2[i].rmsd) < 1e-6);
+    }
+  }
+
+  SECTION("Reference structure") {
+    const zdock::PDB ref(test::getpath("2OOB/ligand.1.pdb"),
+                         zdock::Selection("name CA"));
+    const auto hits = index.nearest(ref.matrix(), 3);
+    REQUIRE(3 == hits.size());
+    REQUIRE(0 == hits[0].index);
+    REQUIRE(hits[0].rmsd < 0.01);
+    REQUIRE(hits[0].rmsd <= hits[1].rmsd);
+    REQUIRE(hits[1].rmsd <= hits[2].rmsd);
+  }
+
+  SECTION("Atom count mismatch") {
+    REQUIRE_THROWS(index.nearest(zdock::PDB::Matrix(3, 2), 1));
+  }
+}
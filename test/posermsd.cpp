@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Eigen/Dense"
+#include "PDB.hpp"
+#include "PoseRMSD.hpp"
+#include "TransformLigand.hpp"
+#include "TransformMultimer.hpp"
+#include "ZDOCK.hpp"
+#include "Test.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+TEST_CASE("Pose RMSD from moments", "[posermsd]") {
+  const zdock::PDB lig(test::getpath("2OOB/ligand.pdb"),
+                       zdock::Selection("name CA"));
+  const zdock::PoseRMSD moments(lig.matrix());
+
+  // brute force RMSD between two poses
+  auto brute = [&lig](const zdock::PoseRMSD::Transform &a,
+                      const zdock::PoseRMSD::Transform &b) {
+    const zdock::PDB::Matrix d = (a * lig.matrix()) - (b * lig.matrix());
+    return std::sqrt(d.colwise().squaredNorm().mean());
+  };
+
+  SECTION("ZDOCK poses") {
+    const zdock::ZDOCK z(test::getpath("2OOB/zdock.out.pruned"));
+    const zdock::TransformLigand txl(z);
+    const auto &preds = z.predictions();
+    const auto tx = txl.transforms(preds, 0, preds.size());
+    const auto emb = moments.embed(tx);
+    REQUIRE(emb.size() == preds.size());
+    for (size_t i = 0; i < preds.size(); i += 11) {
+      for (size_t j = 0; j < preds.size(); j += 13) {
+        const double r = brute(tx[i], tx[j]);
+        REQUIRE(std::abs(
+                    std::sqrt(zdock::PoseRMSD::rmsd2(emb[i], emb[j])) - r) <
+                1e-6);
+        REQUIRE(std::abs(moments.rmsd(tx[i], tx[j]) - r) < 1e-6);
+      }
+      // first three coordinates are the pose centroid
+      const Eigen::Vector3d c = (tx[i] * lig.matrix()).rowwise().mean();
+      REQUIRE((c - Eigen::Vector3d(emb[i][0], emb[i][1], emb[i][2])).norm() <
+              1e-9);
+    }
+  }
+
+  SECTION("M-ZDOCK poses") {
+    const zdock::ZDOCK z(test::getpath("ZDOCK/mzdock.out"));
+    const zdock::TransformMultimer txm(z);
+    const auto &preds = z.predictions();
+    const auto tx0 = txm.transforms(preds, 0, preds.size(), 0);
+    const auto tx1 = txm.transforms(preds, 0, preds.size(), 1);
+    for (size_t i = 0; i < preds.size(); i += 97) {
+      for (size_t j = 0; j < preds.size(); j += 89) {
+        REQUIRE(std::abs(moments.rmsd(tx0[i], tx1[j]) -
+                         brute(tx0[i], tx1[j])) < 1e-6);
+      }
+    }
+  }
+
+  SECTION("Symmetric M-ZDOCK poses") {
+    const zdock::ZDOCK z(test::getpath("ZDOCK/mzdock.out"));
+    const zdock::TransformMultimer txm(z);
+    const auto &preds = z.predictions();
+    const auto tx0 = txm.transforms(preds, 0, preds.size(), 0);
+    const auto emb = moments.embed(tx0);
+    // nearest of all mers of the second pose, against brute force, for
+    // the file's symmetry and larger ones (rotations about z)
+    for (const int symmetry : {txm.symmetry(), 5, 8}) {
+      for (size_t i = 0; i < preds.size(); i += 97) {
+        for (size_t j = 0; j < preds.size(); j += 89) {
+          double r = std::numeric_limits<double>::max();
+          for (int k = 0; k < symmetry; ++k) {
+            const double t = 2.0 * zdock::TransformUtil::PI * k / symmetry;
+            const Eigen::AngleAxisd q(t, Eigen::Vector3d::UnitZ());
+            r = std::min(r, brute(tx0[i], q * tx0[j]));
+          }
+          REQUIRE(std::abs(std::sqrt(zdock::PoseRMSD::rmsd2(
+                               emb[i], emb[j], symmetry)) -
+                           r) < 1e-6);
+        }
+      }
+    }
+    // mer k of TransformMultimer is the k-th such rotation
+    for (int k = 0; k < txm.symmetry(); ++k) {
+      REQUIRE((txm.mer(k) * tx0[0]).matrix().isApprox(
+          txm.transform(preds[0], k).matrix()));
+    }
+  }
+
+  SECTION("Empty structure") {
+    REQUIRE_THROWS(zdock::PoseRMSD(zdock::PoseRMSD::Matrix(3, 0)));
+  }
+}
@@ -73,6 +73,17 @@ TEST_CASE("PDB rotation", "[prediction]") {
       REQUIRE(ncols == p.matrix().rows());
     }
 
+    SECTION("PDB setMatrix") {
+      const zdock::PDB::Matrix m = txl.txLigand(p.matrix(), z.predictions()[0]);
+      p.setMatrix(m);
+      REQUIRE(0 == (p.matrix() - m).squaredNorm());
+      for (size_t i = 0; i < p.atoms().size(); ++i) {
+        REQUIRE(m(0, i) == p.atoms()[i]->atom.xyz[0]);
+        REQUIRE(m(1, i) == p.atoms()[i]->atom.xyz[1]);
+        REQUIRE(m(2, i) == p.atoms()[i]->atom.xyz[2]);
+      }
+    }
+
     SECTION("PDB rotations") {
       const double epsilon = 1.5e-04;
       for (int i = 1; i < 11; ++i) {
@@ -86,6 +97,172 @@ TEST_CASE("PDB rotation", "[prediction]") {
       }
     }
 
+    SECTION("PDB rotations (single precision)") {
+      const double epsilon = 1.5e-04;
+      zdock::PDBf pf(ligand);
+      zdock::TransformLigandf txlf(z);
+      REQUIRE(nrows == pf.matrix().cols());
+      for (int i = 1; i < 11; ++i) {
+        SECTION("Prediction " + std::to_string(i)) {
+          zdock::PDB l(test::getpath(_prefix + std::to_string(i) + ".pdb"));
+          const zdock::PDBf::Matrix m =
+              txlf.txLigand(pf.matrix(), z.predictions()[i - 1]);
+          // against reference structure
+          REQUIRE((m.cast<double>() - l.matrix()).squaredNorm() < epsilon);
+          // against double precision transformation
+          REQUIRE((m.cast<double>() -
+                   txl.txLigand(p.matrix(), z.predictions()[i - 1]))
+                      .squaredNorm() < epsilon);
+        }
+      }
+    }
+
+    SECTION("PDB batch rotations") {
+      const size_t n = p.matrix().cols();
+      const size_t npred = z.predictions().size();
+      zdock::PDB::Matrix poses(3, n * npred);
+      txl.txLigandBatch(p.matrix(), z.predictions(), 0, npred, poses, 3);
+      for (size_t i = 0; i < npred; ++i) {
+        REQUIRE((poses.middleCols(i * n, n) -
+                 txl.txLigand(p.matrix(), z.predictions()[i]))
+                    .squaredNorm() < 1e-16);
+      }
+      // sub-range into a block of a larger buffer
+      poses.setZero();
+      txl.txLigandBatch(p.matrix(), z.predictions(), 5, 15,
+                        poses.middleCols(n, 10 * n));
+      REQUIRE(0 == poses.leftCols(n).squaredNorm());
+      // composed transformations only
+      const auto tx = txl.transforms(z.predictions(), 5, 15);
+      REQUIRE(10 == tx.size());
+      REQUIRE((poses.middleCols(2 * n, n) - tx[1] * p.matrix()).squaredNorm() <
+              1e-16);
+      REQUIRE((poses.middleCols(n, n) -
+               txl.txLigand(p.matrix(), z.predictions()[5]))
+                  .squaredNorm() < 1e-16);
+    }
+
   }
 
 }
+
+TEST_CASE("Transform modes", "[prediction]") {
+  typedef Eigen::Transform<double, 3, Eigen::Affine> Transform;
+  typedef zdock::TransformUtil u;
+  using Eigen::Translation3d;
+  using Eigen::Vector3d;
+
+  // fixed, switched and unfixed ZDOCK files
+  for (const std::string fn : {"ZDOCK/2MTA.zd.out", "ZDOCK/4EEW.zd.out",
+                               "ZDOCK/6GWC.zd.out", "2OOB/zdock.out.pruned"}) {
+    SECTION(fn) {
+      const zdock::ZDOCK z(test::getpath(fn));
+      const zdock::TransformLigand txl(z);
+      const zdock::Structure &rec = z.receptor();
+      const zdock::Structure &lig = z.ligand();
+      for (size_t i = 0; i < std::min<size_t>(50, z.npredictions()); ++i) {
+        const zdock::Prediction &p = z.predictions()[i];
+        const Vector3d d =
+            z.spacing() * u::boxedGridCoord(p.translation, z.boxsize());
+        // reference; full composition of affine transforms
+        Transform t;
+        if (z.isswitched()) {
+          t = Translation3d(Vector3d(rec.translation)) *
+              u::eulerRotation(lig.rotation, true) *
+              u::eulerRotation(p.rotation, true) * Translation3d(d) *
+              Translation3d(-Vector3d(lig.translation)) *
+              u::eulerRotation(rec.rotation);
+        } else {
+          t = Translation3d(Vector3d(rec.translation)) * Translation3d(-d) *
+              u::eulerRotation(p.rotation) * u::eulerRotation(lig.rotation) *
+              Translation3d(-Vector3d(lig.translation));
+          if (!z.isfixed()) {
+            t = u::eulerRotation(rec.rotation, true) * t;
+          }
+        }
+        REQUIRE((txl.transform(p).matrix() - t.matrix()).squaredNorm() <
+                1e-20);
+      }
+    }
+  }
+}
+
+TEST_CASE("Batch transforms grouped by rotation", "[prediction]") {
+  zdock::ZDOCK z(test::getpath("ZDOCK/2MTA.zd.out"));
+  const zdock::PDB p(test::getpath("2OOB/ligand.pdb"));
+  const size_t n = p.matrix().cols();
+  const size_t npred = 300;
+
+  // several translations per rotation
+  const auto v = z.predictions(); // our copy
+  z.predictions().resize(npred);
+  for (size_t i = 0; i < npred; ++i) {
+    std::copy(v[i / 4].rotation, v[i / 4].rotation + 3,
+              z.predictions()[i].rotation);
+  }
+  const zdock::TransformLigand txl(z);
+
+  const auto tx = txl.transforms(z.predictions(), 0, npred);
+  const auto groups = zdock::TransformUtil::groupByRotation(tx);
+  REQUIRE(npred / 4 == groups.size());
+  size_t total = 0;
+  for (const auto &g : groups) {
+    total += g.size();
+    for (const size_t k : g) {
+      REQUIRE(tx[k].linear() == tx[g[0]].linear());
+    }
+  }
+  REQUIRE(npred == total);
+
+  SECTION("Matrix") {
+    zdock::PDB::Matrix poses(3, n * npred);
+    txl.txLigandBatch(p.matrix(), z.predictions(), 0, npred, poses, 2);
+    for (size_t i = 0; i < npred; ++i) {
+      REQUIRE((poses.middleCols(i * n, n) -
+               txl.txLigand(p.matrix(), z.predictions()[i]))
+                  .squaredNorm() < 1e-16);
+    }
+  }
+
+  SECTION("SoA") {
+    const zdock::SoA<double> in(p.matrix());
+    zdock::SoA<double> poses(n, npred);
+    txl.txLigandBatch(in, z.predictions(), 0, npred, poses, 2);
+    for (size_t i = 0; i < npred; ++i) {
+      REQUIRE((poses.matrix(i) - txl.txLigand(p.matrix(), z.predictions()[i]))
+                  .squaredNorm() < 1e-16);
+    }
+  }
+}
+
+TEST_CASE("Batch transforms sharing a single rotation", "[prediction]") {
+  zdock::ZDOCK z(test::getpath("ZDOCK/2MTA.zd.out"));
+  const zdock::PDB p(test::getpath("2OOB/ligand.pdb"));
+  const size_t n = p.matrix().cols();
+  const size_t npred = 257;
+
+  // one rotation for all predictions; poses are still divided over threads
+  const auto v = z.predictions(); // our copy
+  z.predictions().resize(npred);
+  for (size_t i = 0; i < npred; ++i) {
+    std::copy(v[0].rotation, v[0].rotation + 3, z.predictions()[i].rotation);
+  }
+  const zdock::TransformLigand txl(z);
+  REQUIRE(1 == zdock::TransformUtil::groupByRotation(
+                   txl.transforms(z.predictions(), 0, npred))
+                   .size());
+
+  for (const size_t nthreads : {2, 3, 8}) {
+    zdock::PDB::Matrix poses(3, n * npred);
+    txl.txLigandBatch(p.matrix(), z.predictions(), 0, npred, poses,
+                      nthreads);
+    const zdock::SoA<double> in(p.matrix());
+    zdock::SoA<double> soa(n, npred);
+    txl.txLigandBatch(in, z.predictions(), 0, npred, soa, nthreads);
+    for (size_t i = 0; i < npred; ++i) {
+      const auto ref = txl.txLigand(p.matrix(), z.predictions()[i]);
+      REQUIRE((poses.middleCols(i * n, n) - ref).squaredNorm() < 1e-16);
+      REQUIRE((soa.matrix(i) - ref).squaredNorm() < 1e-16);
+    }
+  }
+}
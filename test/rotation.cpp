@@ -25,6 +25,7 @@
  */
 
 #include "Eigen/Dense"
+#include "RotationCache.hpp"
 #include "TransformUtil.hpp"
 #include "Test.hpp"
 
@@ -106,3 +107,45 @@ TEST_CASE("TransformUtil basic checks", "[eulerRotation]") {
     REQUIRE((x - y).squaredNorm() < epsilon);
   }
 }
+
+TEST_CASE("RotationCache", "[eulerRotation]") {
+  const double angles[4][3] = {
+      {0.3, 10.2, 0.1}, {8.2, -1.2, -21}, {0.3, 10.2, 0.1}, {0, 1, 0}};
+  std::vector<zdock::Prediction> preds(4);
+  for (size_t i = 0; i < preds.size(); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      preds[i].rotation[j] = angles[i][j];
+    }
+  }
+  const zdock::RotationCache cache(preds);
+  const double epsilon = 1e-28;
+
+  SECTION("Distinct rotations") {
+    REQUIRE(3 == cache.size());
+    REQUIRE(4 == cache.ids().size());
+    REQUIRE(cache.ids()[0] == cache.ids()[2]);
+    REQUIRE(cache.ids()[1] == cache.id(angles[1]));
+    REQUIRE(-1 == cache.id({1.0, 2.0, 3.0}));
+  }
+
+  SECTION("Matches eulerRotation") {
+    for (size_t i = 0; i < preds.size(); ++i) {
+      for (const bool rev : {false, true}) {
+        REQUIRE((cache.eulerRotation(angles[i], rev).matrix() -
+                 zdock::TransformUtil::eulerRotation(angles[i], rev).matrix())
+                    .squaredNorm() < epsilon);
+      }
+    }
+    // not cached; computed with the same arithmetic as cached rotations
+    zdock::Prediction p;
+    p.rotation[0] = 1.0;
+    p.rotation[1] = 2.0;
+    p.rotation[2] = 3.0;
+    const zdock::RotationCache other({p});
+    REQUIRE(-1 == cache.id(p.rotation));
+    REQUIRE(cache.matrix(p.rotation) == other.matrix(p.rotation));
+    REQUIRE((cache.eulerRotation({1.0, 2.0, 3.0}).matrix() -
+             zdock::TransformUtil::eulerRotation({1.0, 2.0, 3.0}).matrix())
+                .squaredNorm() < epsilon);
+  }
+}
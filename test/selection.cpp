@@ -0,0 +1,142 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Exception.hpp"
+#include "PDB.hpp"
+#include "Selection.hpp"
+#include "Test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+TEST_CASE("Atom selections", "[selection]") {
+  const std::string _ligand = "2OOB/ligand.pdb";
+
+  REQUIRE_NOTHROW(test::getpath(_ligand));
+  const std::string ligand = test::getpath(_ligand);
+
+  SECTION("Selections on PDB construction") {
+    REQUIRE(574 == zdock::PDB(ligand, zdock::Selection()).matrix().cols());
+    REQUIRE(72 == zdock::PDB(ligand, zdock::Selection("name CA"))
+                      .matrix()
+                      .cols());
+    REQUIRE(574 == zdock::PDB(ligand, zdock::Selection("chain b"))
+                       .matrix()
+                       .cols());
+    REQUIRE(0 == zdock::PDB(ligand, zdock::Selection("chain A"))
+                     .matrix()
+                     .cols());
+    REQUIRE(574 == zdock::PDB(ligand, zdock::Selection("not hydrogen"))
+                       .atoms()
+                       .size());
+    REQUIRE(25 == zdock::PDB(ligand, zdock::Selection("resi 1-3"))
+                      .atoms()
+                      .size());
+    REQUIRE(3 == zdock::PDB(ligand, zdock::Selection("resi 1-3 and name CA"))
+                     .atoms()
+                     .size());
+    REQUIRE(21 == zdock::PDB(ligand, zdock::Selection(
+                                         "name CA CB and (resi 10:20)"))
+                      .atoms()
+                      .size());
+    REQUIRE(8 == zdock::PDB(ligand, zdock::Selection("resn MET")).atoms().size());
+    REQUIRE(1 == zdock::PDB(ligand, zdock::Selection("element S")).atoms().size());
+  }
+
+  SECTION("Selected coordinates match records") {
+    zdock::PDB p(ligand, zdock::Selection("name CA or name N"));
+    for (size_t i = 0; i < p.atoms().size(); ++i) {
+      const std::string name = zdock::Utils::trim_copy(p.atoms()[i]->atom.name);
+      REQUIRE(("CA" == name || "N" == name));
+      REQUIRE(p.atoms()[i]->atom.xyz[0] == p.matrix()(0, i));
+      REQUIRE(p.atoms()[i]->atom.xyz[1] == p.matrix()(1, i));
+      REQUIRE(p.atoms()[i]->atom.xyz[2] == p.matrix()(2, i));
+    }
+  }
+
+  SECTION("Selected records") {
+    // atom records are the selected atoms; other records are kept
+    auto natoms = [](const zdock::PDB &p) {
+      size_t n = 0;
+      for (const auto &r : p.records()) {
+        n += (libpdb::PDB::ATOM == r->type() ||
+              libpdb::PDB::HETATM == r->type());
+      }
+      return n;
+    };
+    const zdock::PDB all(ligand, zdock::Selection());
+    const zdock::PDB ca(ligand, zdock::Selection("name CA"));
+    REQUIRE(574 == natoms(all));
+    REQUIRE(72 == natoms(ca));
+    REQUIRE(all.records().size() - 574 == ca.records().size() - 72);
+    size_t k = 0;
+    for (const auto &r : ca.records()) {
+      if (libpdb::PDB::ATOM == r->type() || libpdb::PDB::HETATM == r->type()) {
+        REQUIRE(r == ca.atoms()[k++]);
+      }
+    }
+
+    // models
+    const std::string fn = "/tmp/tmpSeLm0d.pdb";
+    {
+      std::ofstream f(fn);
+      for (int m = 1; m <= 2; ++m) {
+        f << "MODEL     " << std::setw(4) << m << "\n";
+        for (const auto &r : ca.atoms()) {
+          f << *r << "\n";
+        }
+        f << "ENDMDL\n";
+      }
+    }
+    const zdock::PDB models(fn, zdock::Selection("resi 1-3"));
+    std::remove(fn.c_str());
+    REQUIRE(2 == models.models().size());
+    REQUIRE(3 == models.models()[0]->atoms().size());
+    REQUIRE(6 == natoms(models));
+  }
+
+  SECTION("Distance based selections") {
+    REQUIRE(56 == zdock::PDB(ligand, zdock::Selection("within 5 of resi 1"))
+                      .atoms()
+                      .size());
+    REQUIRE(48 == zdock::PDB(ligand, zdock::Selection(
+                                         "within 5 of resi 1 and not resi 1"))
+                      .atoms()
+                      .size());
+  }
+
+  SECTION("Invalid selections") {
+    REQUIRE_THROWS_AS(zdock::Selection(""), zdock::SelectionException);
+    REQUIRE_THROWS_AS(zdock::Selection("name"), zdock::SelectionException);
+    REQUIRE_THROWS_AS(zdock::Selection("foo CA"), zdock::SelectionException);
+    REQUIRE_THROWS_AS(zdock::Selection("(name CA"), zdock::SelectionException);
+    REQUIRE_THROWS_AS(zdock::Selection("resi 1-x"), zdock::SelectionException);
+    REQUIRE_THROWS_AS(zdock::Selection("within x of all"),
+                      zdock::SelectionException);
+  }
+}
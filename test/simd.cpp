@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2019, Arjan van der Velde, Weng Lab
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Eigen/Dense"
+#include "Simd.hpp"
+#include "Test.hpp"
+
+template <typename T> static void checkKernels(const zdock::Simd::Level l) {
+  typedef Eigen::Matrix<T, 3, Eigen::Dynamic> Matrix;
+  const double epsilon = std::is_same<T, float>::value ? 1e-3 : 1e-9;
+  const auto &k = zdock::Simd::kernels<T>(l);
+
+  // odd size; exercises vector body and scalar tail
+  const size_t n = 37;
+  const Matrix a = Matrix::Random(3, n) * 50, b = Matrix::Random(3, n) * 50;
+  zdock::SoA<T> sa(a), sb(b), out(n, 2);
+  REQUIRE(a == sa.matrix());
+
+  // pose application
+  Eigen::Transform<double, 3, Eigen::Affine> tx;
+  tx = Eigen::Translation3d(1.0, -2.0, 3.0) *
+       Eigen::AngleAxisd(0.7, Eigen::Vector3d(1, 2, 3).normalized());
+  T m[12];
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c) {
+      m[3 * r + c] = tx.linear()(r, c);
+    }
+    m[9 + r] = tx.translation()(r);
+  }
+  k.apply(m, sa.x(), sa.y(), sa.z(), n, out.x(1), out.y(1), out.z(1));
+  const Matrix ref = tx.template cast<T>() * a;
+  REQUIRE((out.matrix(1) - ref).squaredNorm() < epsilon);
+  REQUIRE(0 == out.matrix(0).squaredNorm());
+
+  // translation only
+  k.translate(m + 9, sa.x(), sa.y(), sa.z(), n, out.x(0), out.y(0), out.z(0));
+  REQUIRE((out.matrix(0) - (a.colwise() + Eigen::Matrix<T, 3, 1>(m[9], m[10],
+                                                                 m[11])))
+              .squaredNorm() < epsilon);
+
+  // squared distances and deviation
+  std::vector<T> d(n);
+  k.distance2(sa.x(), sa.y(), sa.z(), sb.x(), sb.y(), sb.z(), n, &d[0]);
+  for (size_t i = 0; i < n; ++i) {
+    REQUIRE(std::abs(d[i] - (a.col(i) - b.col(i)).squaredNorm()) < epsilon);
+  }
+  const T dev =
+      k.deviation2(sa.x(), sa.y(), sa.z(), sb.x(), sb.y(), sb.z(), n);
+  REQUIRE(std::abs(dev - (a - b).squaredNorm()) <
+          epsilon * (a - b).squaredNorm());
+}
+
+TEST_CASE("SIMD kernels", "[simd]") {
+  for (const auto l : {zdock::Simd::GENERIC, zdock::Simd::AVX2,
+                       zdock::Simd::AVX512}) {
+    if (zdock::Simd::supported(l)) {
+      SECTION(zdock::Simd::name(l)) {
+        checkKernels<float>(l);
+        checkKernels<double>(l);
+      }
+    }
+  }
+  REQUIRE(zdock::Simd::supported(zdock::Simd::level()));
+}